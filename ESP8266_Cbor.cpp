@@ -0,0 +1,194 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include "ESP8266_Simple.h"
+#include "ESP8266_Cbor.h"
+
+// CBOR major types (the top 3 bits of the first byte)
+#define ESP8266_CBOR_UNSIGNED   0x00
+#define ESP8266_CBOR_NEGATIVE   0x20
+#define ESP8266_CBOR_BYTES      0x40
+#define ESP8266_CBOR_STRING     0x60
+#define ESP8266_CBOR_ARRAY      0x80
+#define ESP8266_CBOR_MAP        0xA0
+#define ESP8266_CBOR_SIMPLE     0xE0
+
+ESP8266_CborWriter::ESP8266_CborWriter(char *buffer, unsigned int bufferLength)
+{
+  this->buffer       = (byte *) buffer;
+  this->bufferLength = bufferLength;
+  this->bufferIndex  = 0;
+  this->overflowed   = 0;
+}
+
+void ESP8266_CborWriter::beginMap(unsigned int numPairs)
+{
+  this->writeHead(ESP8266_CBOR_MAP, numPairs);
+}
+
+void ESP8266_CborWriter::beginArray(unsigned int numItems)
+{
+  this->writeHead(ESP8266_CBOR_ARRAY, numItems);
+}
+
+void ESP8266_CborWriter::add(long value)
+{
+  // Negative numbers are stored as -1 - value, so -1 is 0, -2 is 1...
+  if(value < 0)
+  {
+    this->writeHead(ESP8266_CBOR_NEGATIVE, (unsigned long) (-1 - value));
+  }
+  else
+  {
+    this->writeHead(ESP8266_CBOR_UNSIGNED, (unsigned long) value);
+  }
+}
+
+void ESP8266_CborWriter::add(unsigned long value)
+{
+  this->writeHead(ESP8266_CBOR_UNSIGNED, value);
+}
+
+void ESP8266_CborWriter::add(double value)
+{
+  // On AVR a double is a 32 bit IEEE float anyway, so single precision 
+  // costs us nothing and saves 4 bytes a number
+  float    single = value;
+  uint32_t bits;
+  byte     encoded[5];
+  
+  memcpy(&bits, &single, sizeof(bits));
+  
+  encoded[0] = ESP8266_CBOR_SIMPLE | 26;
+  encoded[1] = bits >> 24;
+  encoded[2] = bits >> 16;
+  encoded[3] = bits >> 8;
+  encoded[4] = bits;
+  this->write(encoded, sizeof(encoded));
+}
+
+void ESP8266_CborWriter::add(const char *string)
+{
+  unsigned int length = strlen(string);
+  
+  this->writeHead(ESP8266_CBOR_STRING, length);
+  this->write(string, length);
+}
+
+void ESP8266_CborWriter::add(const __FlashStringHelper *string)
+{
+  const char  *p      = (const char *) string;
+  unsigned int length = strlen_P(p);
+  
+  this->writeHead(ESP8266_CBOR_STRING, length);
+  if(this->overflowed || length > this->bufferLength - this->bufferIndex)
+  {
+    this->overflowed = 1;
+    return;
+  }
+  
+  memcpy_P(this->buffer + this->bufferIndex, p, length);
+  this->bufferIndex += length;
+}
+
+void ESP8266_CborWriter::addBytes(const byte *data, unsigned int length)
+{
+  this->writeHead(ESP8266_CBOR_BYTES, length);
+  this->write(data, length);
+}
+
+void ESP8266_CborWriter::addBool(byte value)
+{
+  byte encoded = ESP8266_CBOR_SIMPLE | (value ? 21 : 20);
+  this->write(&encoded, 1);
+}
+
+void ESP8266_CborWriter::addNull()
+{
+  byte encoded = ESP8266_CBOR_SIMPLE | 22;
+  this->write(&encoded, 1);
+}
+
+unsigned long ESP8266_CborWriter::response(unsigned int httpStatus)
+{
+  if(this->overflowed)
+  {
+    this->bufferIndex = 0;
+    return ESP8266_CBOR | 500;
+  }
+  
+  return ESP8266_CBOR | ESP8266_BODY_LENGTH(this->bufferIndex) | httpStatus;
+}
+
+// The first byte is the major type, and either the value itself (under 24)
+// or how many bytes of value follow it (24 = 1, 25 = 2, 26 = 4)
+void ESP8266_CborWriter::writeHead(byte majorType, unsigned long value)
+{
+  byte encoded[5];
+  byte length;
+  
+  if(value < 24)
+  {
+    encoded[0] = majorType | value;
+    length     = 1;
+  }
+  else if(value <= 0xFF)
+  {
+    encoded[0] = majorType | 24;
+    encoded[1] = value;
+    length     = 2;
+  }
+  else if(value <= 0xFFFF)
+  {
+    encoded[0] = majorType | 25;
+    encoded[1] = value >> 8;
+    encoded[2] = value;
+    length     = 3;
+  }
+  else
+  {
+    encoded[0] = majorType | 26;
+    encoded[1] = value >> 24;
+    encoded[2] = value >> 16;
+    encoded[3] = value >> 8;
+    encoded[4] = value;
+    length     = 5;
+  }
+  
+  this->write(encoded, length);
+}
+
+void ESP8266_CborWriter::write(const void *data, unsigned int length)
+{
+  if(this->overflowed || length > this->bufferLength - this->bufferIndex)
+  {
+    this->overflowed = 1;
+    return;
+  }
+  
+  memcpy(this->buffer + this->bufferIndex, data, length);
+  this->bufferIndex += length;
+}
@@ -0,0 +1,94 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266Cbor_h
+#define ESP8266Cbor_h
+
+#include <Arduino.h>
+
+/**
+ * A small CBOR (RFC 7049) encoder for HTTP server responses, CBOR is a 
+ * binary JSON, much smaller to send and much easier for a machine to read
+ * than HTML or text.
+ * 
+ * It writes into the buffer your handler is given, maps and arrays are 
+ * started with the number of items in them and then that many items (for a 
+ * map, a key then a value, for each) are added.  When done return response()
+ * from the handler, eg
+ * 
+ *   unsigned long httpReadings(char *buffer, int bufferLength)
+ *   {
+ *     if(!wifi.requestAcceptsCbor()) { ...do it in text instead... }
+ *     
+ *     ESP8266_CborWriter cbor(buffer, bufferLength);
+ *     cbor.beginMap(2);
+ *       cbor.add(F("millis")); cbor.add(millis());
+ *       cbor.add(F("temp"));   cbor.add(21.5);
+ *     return cbor.response(200);
+ *   }
+ * 
+ * If it doesn't fit, response() makes it a 500 error instead.
+ */
+
+class ESP8266_CborWriter
+{
+  public:
+    ESP8266_CborWriter(char *buffer, unsigned int bufferLength);
+    
+    void beginMap(unsigned int numPairs);
+    void beginArray(unsigned int numItems);
+    
+    void add(long value);
+    void add(unsigned long value);
+    void add(int value)          { this->add((long) value);          }
+    void add(unsigned int value) { this->add((unsigned long) value); }
+    void add(double value);
+    void add(const char *string);
+    void add(const __FlashStringHelper *string);
+    void addBytes(const byte *data, unsigned int length);
+    void addBool(byte value);
+    void addNull();
+    
+    unsigned int length()   { return this->bufferIndex; }
+    byte         overflow() { return this->overflowed;  }
+    
+    // The return value for your HTTP server handler (ESP8266_CBOR with the 
+    // length of the body and the status code packed in)
+    unsigned long response(unsigned int httpStatus);
+    
+  protected:
+    void writeHead(byte majorType, unsigned long value);
+    void write(const void *data, unsigned int length);
+    
+    byte         *buffer;
+    unsigned int  bufferLength;
+    unsigned int  bufferIndex;
+    byte          overflowed;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include "ESP8266_Download.h"
+
+#ifdef __AVR__
+  #include <avr/eeprom.h>
+#endif
+
+// Everything here is made of HTTP client requests
+#if ESP8266_ENABLE_HTTP_CLIENT
+
+ESP8266_Download::ESP8266_Download(ESP8266_Simple *esp, ESP8266_DownloadSink sink, void *sinkContext)
+{
+  this->esp         = esp;
+  this->sink        = sink;
+  this->sinkContext = sinkContext;
+  this->serverIp    = 0;
+  this->port        = 80;
+  this->path        = NULL;
+  this->httpHost    = NULL;
+  this->resume(0, 0);
+}
+
+void ESP8266_Download::setSource(unsigned long serverIp, int port, const __FlashStringHelper *path, const __FlashStringHelper *httpHost)
+{
+  this->serverIp = serverIp;
+  this->port     = port;
+  this->path     = path;
+  this->httpHost = httpHost;
+  this->resume(0, 0);
+}
+
+void ESP8266_Download::resume(unsigned long offset, uint32_t crc)
+{
+  this->offset = offset;
+  this->crc    = crc;
+  this->length = -1;
+}
+
+byte ESP8266_Download::finished()
+{
+  return this->length >= 0 && this->offset >= (unsigned long) this->length;
+}
+
+unsigned long ESP8266_Download::getOffset()
+{
+  return this->offset;
+}
+
+long ESP8266_Download::getLength()
+{
+  return this->length;
+}
+
+uint32_t ESP8266_Download::getCrc()
+{
+  return this->crc;
+}
+
+byte ESP8266_Download::step(char *buffer, int bufferLength)
+{
+  if(!this->path || !this->httpHost || bufferLength < 2) return ESP8266_ERROR;
+  if(this->finished()) return ESP8266_OK;
+  
+  ESP8266_HttpRequest request;
+  ESP8266_HttpHeaders headers;
+  char rangeHeader[40];
+  char httpHostBuffer[strlen_P((const char *)this->httpHost)+1];
+  int  httpResponseCode = 0;
+  byte responseCode;
+  
+  // Ask for as much as will fit (the buffer needs a null on the end)
+  unsigned long last = this->offset + bufferLength - 2;
+  if(this->length >= 0 && last >= (unsigned long) this->length) last = this->length - 1;
+  unsigned long wanted = last - this->offset + 1;
+  
+  strcpy_P(rangeHeader, PSTR("Range: bytes="));
+  ultoa(this->offset, rangeHeader+strlen(rangeHeader), 10);
+  strcat_P(rangeHeader, PSTR("-"));
+  ultoa(last, rangeHeader+strlen(rangeHeader), 10);
+  strcat_P(rangeHeader, PSTR("\r\n"));
+  
+  strcpy_P(httpHostBuffer, (const char *)this->httpHost);
+  strncpy_P(buffer, (const char *)this->path, bufferLength-1);
+  buffer[bufferLength-1] = 0;
+  
+  request.extraHeaders    = rangeHeader;
+  request.responseHeaders = &headers;
+  
+  responseCode = this->esp->sendHttpRequest(this->serverIp, this->port, buffer, bufferLength, httpHostBuffer, &request, 1, &httpResponseCode);
+  if(responseCode != ESP8266_OK) return responseCode;
+  
+  if(httpResponseCode == 206)
+  {
+    if(headers.rangeTotal >= 0) this->length = headers.rangeTotal;
+  }
+  else if(httpResponseCode == 200 && this->offset == 0)
+  {
+    // The server ignored the Range, that's fine if it all fitted
+    this->length = headers.contentLength;
+  }
+  else if(httpResponseCode == 416 && headers.rangeTotal >= 0 && this->offset >= (unsigned long) headers.rangeTotal)
+  {
+    // We asked for past the end, so we must have it all already
+    this->length = headers.rangeTotal;
+    return ESP8266_OK;
+  }
+  else
+  {
+    return ESP8266_ERROR;
+  }
+  
+  // Only take a piece we know we got all of, a short read means the link dropped
+  if(headers.contentLength <= 0 || headers.bodyLength != headers.contentLength || headers.contentLength > bufferLength - 1) 
+  {
+    return ESP8266_ERROR;
+  }
+  
+  responseCode = (this->sink)(this->offset, (const byte *) buffer, headers.contentLength, this->sinkContext);
+  if(responseCode != ESP8266_OK) return responseCode;
+  
+  this->crc     = updateCrc(this->crc, (const byte *) buffer, headers.contentLength);
+  this->offset += headers.contentLength;
+  
+  // If we still don't know how long it is, a short piece must be the last one
+  if(this->length < 0 && (unsigned long) headers.contentLength < wanted)
+  {
+    this->length = this->offset;
+  }
+  
+  return ESP8266_OK;
+}
+
+byte ESP8266_Download::run(char *buffer, int bufferLength, byte maxFailures)
+{
+  byte failures = 0;
+  byte responseCode;
+  
+  while(!this->finished())
+  {
+    responseCode = this->step(buffer, bufferLength);
+    if(responseCode == ESP8266_OK)
+    {
+      failures = 0;
+    }
+    else if(++failures >= maxFailures)
+    {
+      return responseCode;
+    }
+  }
+  
+  return ESP8266_OK;
+}
+
+// CRC-32 (reflected, polynomial 0xEDB88320), a table would be faster but costs 1k of flash
+uint32_t ESP8266_Download::updateCrc(uint32_t crc, const byte *data, unsigned int length)
+{
+  crc = ~crc;
+  while(length--)
+  {
+    crc ^= *data++;
+    for(byte bit = 0; bit < 8; bit++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+#ifdef __AVR__
+byte ESP8266_Download::eepromSink(unsigned long offset, const byte *data, unsigned int length, void *context)
+{
+  unsigned int eepromAddress = *((unsigned int *) context);
+  
+  if(offset + length > E2END + 1 - eepromAddress) return ESP8266_OVERFLOW;
+  
+  eeprom_update_block(data, (void *)(eepromAddress + offset), length);
+  return ESP8266_OK;
+}
+#endif
+
+#endif // ESP8266_ENABLE_HTTP_CLIENT
@@ -0,0 +1,117 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266Download_h
+#define ESP8266Download_h
+
+#include "ESP8266_Simple.h"
+
+// Stores one piece of a download, data is length bytes from offset (pieces 
+// arrive in order), return ESP8266_OK once it is safely stored, anything else 
+// and the piece will be fetched again.
+typedef byte (*ESP8266_DownloadSink)(unsigned long offset, const byte *data, unsigned int length, void *context);
+
+/**
+ * Downloads something too big to fit in RAM (a lookup table, a firmware 
+ * image...) in pieces using HTTP Range requests, each piece as big as the 
+ * buffer you give, and hands each piece to a sink function which stores it 
+ * (in EEPROM, on an SD card, in external flash...).
+ * 
+ * If a piece fails, only that piece is fetched again, and if you save 
+ * getOffset() and getCrc() as you go (eg in your sink) you can resume() 
+ * after a reset without fetching again what you already have.
+ * 
+ * A CRC-32 (the same as zlib/PNG/Ethernet) of everything stored is kept,
+ * compare getCrc() with what you expected once finished().
+ * 
+ * The server must support Range requests (any static file server does), 
+ * unless the whole thing fits in one piece anyway.
+ * 
+ * See the Download example for more information.
+ */
+
+class ESP8266_Download
+{
+  public:
+    ESP8266_Download(ESP8266_Simple *esp, ESP8266_DownloadSink sink, void *sinkContext = NULL);
+    
+    /** 
+     * What to download, the strings must be F() strings, the httpHost is 
+     * required (without it we don't get the headers we need).
+     * 
+     * This starts again from the beginning.
+     */
+    void setSource(unsigned long serverIp, int port, const __FlashStringHelper *path, const __FlashStringHelper *httpHost);
+    
+    // Carry on from a previous getOffset() and getCrc()
+    void resume(unsigned long offset, uint32_t crc);
+    
+    /**
+     * Fetch and store the next piece, the buffer must be bigger than the longest
+     * line of response headers the server sends (say 100 bytes at least).
+     * 
+     * @return ESP8266_OK (including if already finished), or an error code, 
+     *   ESP8266_ERROR if the server didn't do what we asked
+     */
+    byte step(char *buffer, int bufferLength);
+    
+    /**
+     * Fetch pieces until finished(), giving up after maxFailures failures
+     * in a row (the next call will carry on from where it got to).
+     */
+    byte run(char *buffer, int bufferLength, byte maxFailures = 5);
+    
+    byte          finished();
+    unsigned long getOffset();
+    long          getLength();   // -1 if we don't know yet
+    uint32_t      getCrc();
+    
+    static uint32_t updateCrc(uint32_t crc, const byte *data, unsigned int length);
+
+#ifdef __AVR__
+    // A sink which stores in EEPROM, the context is a pointer to an 
+    // unsigned int which holds the EEPROM address to start at
+    static byte eepromSink(unsigned long offset, const byte *data, unsigned int length, void *context);
+#endif
+    
+  protected:
+    ESP8266_Simple      *esp;
+    ESP8266_DownloadSink sink;
+    void                *sinkContext;
+    
+    unsigned long        serverIp;
+    int                  port;
+    const __FlashStringHelper *path;
+    const __FlashStringHelper *httpHost;
+    
+    unsigned long        offset;
+    long                 length;
+    uint32_t             crc;
+};
+
+#endif
@@ -0,0 +1,231 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include "ESP8266_HttpCache.h"
+
+#ifdef __AVR__
+  #include <avr/eeprom.h>
+#endif
+
+// Everything here is made of HTTP client requests
+#if ESP8266_ENABLE_HTTP_CLIENT
+
+ESP8266_HttpCache::ESP8266_HttpCache(ESP8266_Simple *esp, unsigned int maxBodySize)
+{
+  this->esp           = esp;
+  this->maxBodySize   = maxBodySize;
+  this->slotSize      = sizeof(ESP8266_HttpCacheEntry) + maxBodySize;
+  this->buffer        = NULL;
+  this->storageSize   = 0;
+  this->eepromAddress = 0;
+  this->useEeprom     = 0;
+  this->nextVictim    = 0;
+  this->lastWasCached = 0;
+}
+
+void ESP8266_HttpCache::setStorage(void *buffer, unsigned int bufferSize)
+{
+  this->buffer      = (byte *) buffer;
+  this->storageSize = bufferSize;
+  this->useEeprom   = 0;
+  this->clear();
+}
+
+#ifdef __AVR__
+void ESP8266_HttpCache::setEepromStorage(unsigned int eepromAddress, unsigned int eepromSize)
+{
+  // Not cleared, the whole point is to remember what we had before
+  this->eepromAddress = eepromAddress;
+  this->storageSize   = eepromSize;
+  this->useEeprom     = 1;
+}
+#endif
+
+unsigned int ESP8266_HttpCache::numSlots()
+{
+  return this->storageSize / this->slotSize;
+}
+
+byte ESP8266_HttpCache::wasCached()
+{
+  return this->lastWasCached;
+}
+
+void ESP8266_HttpCache::clear()
+{
+  uint32_t empty = 0;
+  
+  for(unsigned int slot = 0; slot < this->numSlots(); slot++)
+  {
+    this->writeStorage(slot * this->slotSize, &empty, sizeof(empty));
+  }
+}
+
+unsigned int ESP8266_HttpCache::GET(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, int bodyResponseOnlyFromLine)
+{
+  ESP8266_HttpCacheEntry entry;
+  ESP8266_HttpRequest    request;
+  ESP8266_HttpHeaders    headers;
+  char extraHeaders[ESP8266_HTTPCACHE_VALIDATOR_SIZE + 24];
+  char etag[ESP8266_HTTPCACHE_VALIDATOR_SIZE];
+  char lastModified[ESP8266_HTTPCACHE_VALIDATOR_SIZE];
+  char httpHostBuffer[strlen_P((const char *)httpHost)+1];
+  int  httpResponseCode = 0;
+  byte responseCode;
+  unsigned int bodyLength;
+  uint32_t key;
+  int  slot;
+  
+  this->lastWasCached = 0;
+  
+  strcpy_P(httpHostBuffer, (const char *)httpHost);
+  
+  // The path gets overwritten by the response, so work out where it goes first
+  key  = this->hashKey(httpHostBuffer, requestPathAndResponseBuffer);
+  slot = this->findSlot(key, entry);
+  
+  // Tell the server what we have
+  extraHeaders[0] = 0;
+  if(slot >= 0)
+  {
+    strcpy_P(extraHeaders, entry.validatorType == 'E' ? PSTR("If-None-Match: ") : PSTR("If-Modified-Since: "));
+    strncat(extraHeaders, entry.validator, ESP8266_HTTPCACHE_VALIDATOR_SIZE - 1);
+    strcat_P(extraHeaders, PSTR("\r\n"));
+    request.extraHeaders = extraHeaders;
+  }
+  
+  etag[0] = lastModified[0] = 0;
+  headers.etag             = etag;
+  headers.etagSize         = sizeof(etag);
+  headers.lastModified     = lastModified;
+  headers.lastModifiedSize = sizeof(lastModified);
+  request.responseHeaders  = &headers;
+  
+  responseCode = this->esp->sendHttpRequest(serverIp, port, requestPathAndResponseBuffer, bufferLength, httpHostBuffer, &request, bodyResponseOnlyFromLine, &httpResponseCode);
+  if(responseCode != ESP8266_OK) return responseCode;
+  
+  if(httpResponseCode == 304 && slot >= 0)
+  {
+    if(entry.bodyLength == ESP8266_HTTPCACHE_NO_BODY || entry.bodyLength >= (unsigned int) bufferLength) return 304;
+    
+    memset(requestPathAndResponseBuffer, 0, bufferLength);
+    this->readStorage(slot * this->slotSize + sizeof(entry), requestPathAndResponseBuffer, entry.bodyLength);
+    this->lastWasCached = 1;
+    return 200;
+  }
+  
+  if(httpResponseCode != 200) return httpResponseCode;
+  
+  // Only keep it if there is a validator which fits, and we got all of the
+  // body (or at least, it didn't fill the buffer)
+  bodyLength = strlen(requestPathAndResponseBuffer);
+  if(headers.contentLength >= 0 && bodyResponseOnlyFromLine == 1 && (unsigned long) headers.contentLength != bodyLength) return 200;
+  if(bodyLength >= (unsigned int) bufferLength - 1) return 200;
+  
+  memset(&entry, 0, sizeof(entry));
+  if(etag[0] && strlen(etag) < sizeof(etag) - 1)
+  {
+    entry.validatorType = 'E';
+    strcpy(entry.validator, etag);
+  }
+  else if(lastModified[0] && strlen(lastModified) < sizeof(lastModified) - 1)
+  {
+    entry.validatorType = 'M';
+    strcpy(entry.validator, lastModified);
+  }
+  else
+  {
+    return 200;
+  }
+  
+  entry.key        = key;
+  entry.bodyLength = bodyLength <= this->maxBodySize ? bodyLength : ESP8266_HTTPCACHE_NO_BODY;
+  
+  if(slot < 0)
+  {
+    if(!this->numSlots()) return 200;
+    slot = this->nextVictim;
+    this->nextVictim = (this->nextVictim + 1) % this->numSlots();
+  }
+  
+  this->writeStorage(slot * this->slotSize, &entry, sizeof(entry));
+  if(entry.bodyLength != ESP8266_HTTPCACHE_NO_BODY)
+  {
+    this->writeStorage(slot * this->slotSize + sizeof(entry), requestPathAndResponseBuffer, bodyLength);
+  }
+  
+  return 200;
+}
+
+// FNV-1a of the host and path, avoiding the values which mean empty
+uint32_t ESP8266_HttpCache::hashKey(const char *httpHost, const char *path)
+{
+  uint32_t hash = 2166136261UL;
+  
+  for(; *httpHost; httpHost++) hash = (hash ^ (byte) *httpHost) * 16777619UL;
+  hash = (hash ^ '/') * 16777619UL;
+  for(; *path; path++)         hash = (hash ^ (byte) *path) * 16777619UL;
+  
+  if(hash == 0 || hash == 0xFFFFFFFFUL) hash = 1;
+  return hash;
+}
+
+int ESP8266_HttpCache::findSlot(uint32_t key, ESP8266_HttpCacheEntry &entry)
+{
+  for(unsigned int slot = 0; slot < this->numSlots(); slot++)
+  {
+    this->readStorage(slot * this->slotSize, &entry, sizeof(entry));
+    if(entry.key == key) return slot;
+  }
+  
+  return -1;
+}
+
+void ESP8266_HttpCache::readStorage(unsigned int offset, void *data, unsigned int length)
+{
+#ifdef __AVR__
+  if(this->useEeprom)
+  {
+    eeprom_read_block(data, (const void *)(this->eepromAddress + offset), length);
+    return;
+  }
+#endif
+  memcpy(data, this->buffer + offset, length);
+}
+
+void ESP8266_HttpCache::writeStorage(unsigned int offset, const void *data, unsigned int length)
+{
+#ifdef __AVR__
+  if(this->useEeprom)
+  {
+    eeprom_update_block(data, (void *)(this->eepromAddress + offset), length);
+    return;
+  }
+#endif
+  if(this->buffer) memcpy(this->buffer + offset, data, length);
+}
+
+#endif // ESP8266_ENABLE_HTTP_CLIENT
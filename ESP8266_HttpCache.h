@@ -0,0 +1,119 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266HttpCache_h
+#define ESP8266HttpCache_h
+
+#include "ESP8266_Simple.h"
+
+// The longest ETag or Last-Modified we keep, longer ones are not cached
+#ifndef ESP8266_HTTPCACHE_VALIDATOR_SIZE
+  #define ESP8266_HTTPCACHE_VALIDATOR_SIZE 36
+#endif
+
+#define ESP8266_HTTPCACHE_NO_BODY 0xFFFF
+
+// One entry in the cache, the body (if kept) follows it in the storage
+struct ESP8266_HttpCacheEntry
+{
+    uint32_t     key;            // Hash of the host and path, 0 or 0xFFFFFFFF (blank EEPROM) is empty
+    char         validatorType;  // 'E' for an ETag, 'M' for Last-Modified
+    char         validator[ESP8266_HTTPCACHE_VALIDATOR_SIZE];
+    unsigned int bodyLength;     // ESP8266_HTTPCACHE_NO_BODY if only the validator is kept
+};
+
+/**
+ * A cache for GET requests of things which rarely change (configuration 
+ * documents and the like).  The ETag or Last-Modified of each response is 
+ * kept, along with the body if it's small enough, and sent with the next
+ * request for it (If-None-Match/If-Modified-Since), if the server says 
+ * "304 Not Modified" the body is served from the cache without being sent
+ * again.
+ * 
+ * The cache can be kept in a buffer you provide, or in EEPROM (AVR only)
+ * so that it survives a reset.  Either way it is divided into slots of
+ * sizeof(ESP8266_HttpCacheEntry) + maxBodySize bytes.
+ * 
+ * See the HttpCache example for more information.
+ */
+
+class ESP8266_HttpCache
+{
+  public:
+    /**
+     * @param esp         The ESP8266 to make requests with
+     * @param maxBodySize The largest body to keep, 0 to keep only validators (so a
+     *                    GET() of something which didn't change gives 304)
+     */
+    ESP8266_HttpCache(ESP8266_Simple *esp, unsigned int maxBodySize);
+    
+    // Keep the cache in RAM
+    void setStorage(void *buffer, unsigned int bufferSize);
+    
+#ifdef __AVR__
+    // Keep the cache in eepromSize bytes of EEPROM from eepromAddress (only
+    // changed bytes are written, so unchanged documents don't wear it)
+    void setEepromStorage(unsigned int eepromAddress, unsigned int eepromSize);
+#endif
+    
+    /**
+     * As ESP8266_Simple::GET(), if the document hasn't changed since it was
+     * cached, the cached body is put in the buffer and 200 returned (and 
+     * wasCached() is true), if it hasn't changed and the body wasn't kept 
+     * then 304 is returned.
+     * 
+     * httpHost is needed, without it the server won't send headers.
+     */
+    unsigned int GET(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, int bodyResponseOnlyFromLine = 1);
+    
+    // If the last GET() was served from the cache
+    byte wasCached();
+    
+    // Forget everything
+    void clear();
+    
+    unsigned int numSlots();
+    
+  protected:
+    uint32_t hashKey(const char *httpHost, const char *path);
+    int      findSlot(uint32_t key, ESP8266_HttpCacheEntry &entry);
+    void     readStorage(unsigned int offset, void *data, unsigned int length);
+    void     writeStorage(unsigned int offset, const void *data, unsigned int length);
+    
+    ESP8266_Simple *esp;
+    unsigned int    maxBodySize;
+    unsigned int    slotSize;
+    byte           *buffer;
+    unsigned int    storageSize;
+    unsigned int    eepromAddress;
+    byte            useEeprom;
+    byte            nextVictim;      // Slots are replaced round robin
+    byte            lastWasCached;
+};
+
+#endif
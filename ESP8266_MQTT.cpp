@@ -0,0 +1,421 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include "ESP8266_MQTT.h"
+
+#define ESP8266_MQTT_PARSE_HEADER 0
+#define ESP8266_MQTT_PARSE_LENGTH 1
+#define ESP8266_MQTT_PARSE_BODY   2
+
+ESP8266_MQTT::ESP8266_MQTT(ESP8266_Simple *esp, char *buffer, int bufferSize, int muxChannel)
+{
+  this->esp              = esp;
+  this->buffer           = buffer;
+  this->bufferSize       = bufferSize;
+  this->muxChannel       = muxChannel;
+  this->messageHandler   = NULL;
+  this->isConnected      = 0;
+  this->receiving        = 0;
+  this->nextPacketId     = 1;
+  this->keepAliveSeconds = 0;
+  this->lastSentMillis   = 0;
+  this->pingSentMillis   = 0;
+  this->ackType          = 0;
+  this->ackPacketId      = 0;
+  this->ackReturnCode    = 0;
+  this->parseState       = ESP8266_MQTT_PARSE_HEADER;
+  this->numPendingAcks   = 0;
+}
+
+void ESP8266_MQTT::setMessageHandler(ESP8266_MQTTMessageHandler messageHandler)
+{
+  this->messageHandler = messageHandler;
+}
+
+byte ESP8266_MQTT::connected()
+{
+  return this->isConnected;
+}
+
+byte ESP8266_MQTT::connect(unsigned long brokerIpAddress, int port, const char *clientId, const char *username, const char *password, unsigned int keepAliveSeconds, byte cleanSession)
+{
+  char segment[ESP8266_SEND_SEGMENT_SIZE];
+  byte responseCode;
+  byte flags = cleanSession ? 0x02 : 0x00;
+  unsigned long remainingLength = 10 + 2 + strlen(clientId);
+  
+  if(username) { flags |= 0x80; remainingLength += 2 + strlen(username); }
+  if(password) { flags |= 0x40; remainingLength += 2 + strlen(password); }
+  
+  this->isConnected      = 0;
+  this->keepAliveSeconds = keepAliveSeconds;
+  this->parseState       = ESP8266_MQTT_PARSE_HEADER;
+  this->pingSentMillis   = 0;
+  
+  if((responseCode = this->esp->openConnection(ESP8266_TCP, brokerIpAddress, port, 0, this->muxChannel)) != ESP8266_OK)
+  {
+    return responseCode;
+  }
+  
+  ESP8266_SendBuffer packet(this->esp, this->muxChannel, segment, sizeof(segment));
+  this->writeHeader(&packet, ESP8266_MQTT_CONNECT, remainingLength);
+  this->writeString(&packet, "MQTT");
+  packet.write(0x04);   // Protocol level 3.1.1
+  packet.write(flags);
+  packet.write((uint8_t) (keepAliveSeconds >> 8));
+  packet.write((uint8_t) (keepAliveSeconds & 0xFF));
+  this->writeString(&packet, clientId);
+  if(username) this->writeString(&packet, username);
+  if(password) this->writeString(&packet, password);
+  
+  if((responseCode = packet.send()) != ESP8266_OK) return responseCode;
+  this->lastSentMillis = millis();
+  
+  if((responseCode = this->waitForAck(ESP8266_MQTT_CONNACK, 0)) != ESP8266_OK) return responseCode;
+  
+  // Return code 0 is accepted, anything else is a refusal
+  if(this->ackReturnCode != 0)
+  {
+    this->esp->closeConnection(this->muxChannel);
+    return ESP8266_ERROR;
+  }
+  
+  this->isConnected = 1;
+  return ESP8266_OK;
+}
+
+byte ESP8266_MQTT::disconnect()
+{
+  char packet[2] = { (char) ESP8266_MQTT_DISCONNECT, 0 };
+  
+  if(this->isConnected)
+  {
+    this->esp->sendData(this->muxChannel, packet, sizeof(packet));
+  }
+  
+  this->isConnected = 0;
+  return this->esp->closeConnection(this->muxChannel);
+}
+
+byte ESP8266_MQTT::publish(const char *topic, const char *payload, byte qos, byte retain)
+{
+  return this->publish(topic, payload, strlen(payload), qos, retain);
+}
+
+byte ESP8266_MQTT::publish(const char *topic, const char *payload, int length, byte qos, byte retain)
+{
+  char segment[ESP8266_SEND_SEGMENT_SIZE];
+  byte responseCode = ESP8266_ERROR;
+  byte header;
+  byte attempt;
+  unsigned int packetId = 0;
+  
+  if(!this->isConnected) return ESP8266_ERROR;
+  if(this->receiving)    return ESP8266_BUSY;
+  
+  qos = qos ? 1 : 0;
+  if(qos)
+  {
+    packetId = this->nextPacketId++;
+    if(!this->nextPacketId) this->nextPacketId = 1;
+  }
+  
+  for(attempt = 0; attempt < (qos ? ESP8266_MQTT_PUBLISH_ATTEMPTS : 1); attempt++)
+  {
+    // A resend has the DUP flag
+    header = ESP8266_MQTT_PUBLISH | (qos << 1) | (retain ? 0x01 : 0x00) | (attempt ? 0x08 : 0x00);
+    
+    ESP8266_SendBuffer packet(this->esp, this->muxChannel, segment, sizeof(segment));
+    this->writeHeader(&packet, header, 2 + strlen(topic) + (qos ? 2 : 0) + length);
+    this->writeString(&packet, topic);
+    if(qos)
+    {
+      packet.write((uint8_t) (packetId >> 8));
+      packet.write((uint8_t) (packetId & 0xFF));
+    }
+    packet.write((const uint8_t *) payload, length);
+    
+    if((responseCode = packet.send()) != ESP8266_OK)
+    {
+      this->isConnected = 0;
+      return responseCode;
+    }
+    this->lastSentMillis = millis();
+    
+    if(!qos) return ESP8266_OK;
+    
+    if((responseCode = this->waitForAck(ESP8266_MQTT_PUBACK, packetId)) == ESP8266_OK) return ESP8266_OK;
+    if(!this->isConnected) break;
+  }
+  
+  return responseCode;
+}
+
+byte ESP8266_MQTT::subscribe(const char *topic, byte qos)
+{
+  char segment[ESP8266_SEND_SEGMENT_SIZE];
+  byte responseCode;
+  unsigned int packetId = this->nextPacketId++;
+  
+  if(!this->nextPacketId) this->nextPacketId = 1;
+  
+  if(!this->isConnected) return ESP8266_ERROR;
+  if(this->receiving)    return ESP8266_BUSY;
+  
+  ESP8266_SendBuffer packet(this->esp, this->muxChannel, segment, sizeof(segment));
+  this->writeHeader(&packet, ESP8266_MQTT_SUBSCRIBE | 0x02, 2 + 2 + strlen(topic) + 1);
+  packet.write((uint8_t) (packetId >> 8));
+  packet.write((uint8_t) (packetId & 0xFF));
+  this->writeString(&packet, topic);
+  packet.write(qos ? 1 : 0);
+  
+  if((responseCode = packet.send()) != ESP8266_OK)
+  {
+    this->isConnected = 0;
+    return responseCode;
+  }
+  this->lastSentMillis = millis();
+  
+  if((responseCode = this->waitForAck(ESP8266_MQTT_SUBACK, packetId)) != ESP8266_OK) return responseCode;
+  
+  // 0x80 is a failure, otherwise it's the QoS granted
+  return this->ackReturnCode == 0x80 ? ESP8266_ERROR : ESP8266_OK;
+}
+
+byte ESP8266_MQTT::loop()
+{
+  char packet[2] = { (char) ESP8266_MQTT_PINGREQ, 0 };
+  
+  if(!this->isConnected) return ESP8266_ERROR;
+  
+  this->receive(0);
+  
+  if(this->esp->isConnectionClosed(this->muxChannel))
+  {
+    this->isConnected = 0;
+    return ESP8266_ERROR;
+  }
+  
+  if(!this->keepAliveSeconds) return ESP8266_OK;
+  
+  // The broker didn't answer our ping, it's gone
+  if(this->pingSentMillis && millis() - this->pingSentMillis > this->keepAliveSeconds * 1000UL)
+  {
+    this->isConnected = 0;
+    this->esp->closeConnection(this->muxChannel);
+    return ESP8266_TIMEOUT;
+  }
+  
+  // We have to say something within the keep alive time, leave some margin
+  if(!this->pingSentMillis && millis() - this->lastSentMillis > this->keepAliveSeconds * 750UL)
+  {
+    if(this->esp->sendData(this->muxChannel, packet, sizeof(packet)) != ESP8266_OK)
+    {
+      this->isConnected = 0;
+      return ESP8266_ERROR;
+    }
+    this->lastSentMillis = this->pingSentMillis = millis();
+  }
+  
+  return ESP8266_OK;
+}
+
+// Read one packet of incoming data (if any) and parse it
+byte ESP8266_MQTT::receive(unsigned long maxWaitMillis)
+{
+  char chunk[16];
+  int  muxChannel = -1;
+  int  bytesRead;
+  int  i;
+  
+  if(!this->esp->readPacketHeader(&muxChannel, maxWaitMillis)) return 0;
+  
+  // In MUX mode, somebody else's packet is no concern of ours
+  if(muxChannel != this->muxChannel)
+  {
+    this->esp->skipPacketData();
+    return 0;
+  }
+  
+  this->receiving = 1;
+  while((bytesRead = this->esp->readPacketData(chunk, sizeof(chunk))) > 0)
+  {
+    for(i = 0; i < bytesRead; i++) this->parse(chunk[i]);
+  }
+  this->receiving = 0;
+  
+  // Now the packet has been read we can acknowledge what was in it
+  for(i = 0; i < this->numPendingAcks; i++)
+  {
+    this->sendAck(ESP8266_MQTT_PUBACK, this->pendingAcks[i]);
+  }
+  this->numPendingAcks = 0;
+  
+  return 1;
+}
+
+void ESP8266_MQTT::parse(byte c)
+{
+  switch(this->parseState)
+  {
+    case ESP8266_MQTT_PARSE_HEADER:
+      this->packetHeader    = c;
+      this->remainingLength = 0;
+      this->lengthShift     = 0;
+      this->bodyIndex       = 0;
+      this->parseState      = ESP8266_MQTT_PARSE_LENGTH;
+      break;
+      
+    case ESP8266_MQTT_PARSE_LENGTH:
+      // 7 bits at a time, least significant first, the top bit means there's more
+      this->remainingLength |= (unsigned long) (c & 0x7F) << this->lengthShift;
+      this->lengthShift += 7;
+      if(c & 0x80) break;
+      
+      this->parseState = ESP8266_MQTT_PARSE_BODY;
+      if(this->remainingLength == 0)
+      {
+        this->dispatch();
+        this->parseState = ESP8266_MQTT_PARSE_HEADER;
+      }
+      break;
+      
+    case ESP8266_MQTT_PARSE_BODY:
+      // Keep what fits (and one byte for a terminator)
+      if(this->bodyIndex < (unsigned long) this->bufferSize - 1) this->buffer[this->bodyIndex] = c;
+      
+      if(++this->bodyIndex == this->remainingLength)
+      {
+        this->dispatch();
+        this->parseState = ESP8266_MQTT_PARSE_HEADER;
+      }
+      break;
+  }
+}
+
+// A whole packet has been parsed
+void ESP8266_MQTT::dispatch()
+{
+  unsigned int  topicLength;
+  unsigned int  payloadStart;
+  unsigned long stored = min(this->bodyIndex, (unsigned long) this->bufferSize - 1);
+  byte qos;
+  
+  switch(this->packetHeader & 0xF0)
+  {
+    case ESP8266_MQTT_CONNACK:
+      this->ackType       = ESP8266_MQTT_CONNACK;
+      this->ackPacketId   = 0;
+      this->ackReturnCode = stored >= 2 ? this->buffer[1] : 0xFF;
+      break;
+      
+    case ESP8266_MQTT_PUBACK:
+    case ESP8266_MQTT_SUBACK:
+      this->ackType       = this->packetHeader & 0xF0;
+      this->ackPacketId   = stored >= 2 ? ((byte) this->buffer[0] << 8) | (byte) this->buffer[1] : 0;
+      this->ackReturnCode = stored >= 3 ? this->buffer[2] : 0;
+      break;
+      
+    case ESP8266_MQTT_PINGRESP:
+      this->pingSentMillis = 0;
+      break;
+      
+    case ESP8266_MQTT_PUBLISH:
+      qos = (this->packetHeader >> 1) & 0x03;
+      if(stored < 2) break;
+      
+      topicLength  = ((byte) this->buffer[0] << 8) | (byte) this->buffer[1];
+      payloadStart = 2 + topicLength + (qos ? 2 : 0);
+      if(payloadStart > stored) break; // The topic didn't fit, nothing we can do
+      
+      if(qos && this->numPendingAcks < ESP8266_MQTT_MAX_PENDING_ACKS)
+      {
+        this->pendingAcks[this->numPendingAcks++] = ((byte) this->buffer[2+topicLength] << 8) | (byte) this->buffer[3+topicLength];
+      }
+      
+      // Move the topic down over it's length so it can be null terminated
+      // without treading on the payload
+      memmove(this->buffer, this->buffer+2, topicLength);
+      this->buffer[topicLength] = 0;
+      this->buffer[stored]      = 0;
+      
+      if(this->messageHandler)
+      {
+        this->messageHandler(this->buffer, this->buffer+payloadStart, stored-payloadStart);
+      }
+      break;
+  }
+}
+
+byte ESP8266_MQTT::waitForAck(byte packetType, unsigned int packetId)
+{
+  unsigned long startMillis = millis();
+  
+  this->ackType = 0;
+  
+  do
+  {
+    this->receive(50);
+    
+    if(this->ackType == packetType && this->ackPacketId == packetId) return ESP8266_OK;
+    
+    if(this->esp->isConnectionClosed(this->muxChannel))
+    {
+      this->isConnected = 0;
+      return ESP8266_ERROR;
+    }
+  } while(millis() - startMillis < ESP8266_MQTT_ACK_TIMEOUT);
+  
+  return ESP8266_TIMEOUT;
+}
+
+byte ESP8266_MQTT::sendAck(byte header, unsigned int packetId)
+{
+  char packet[4] = { (char) header, 2, (char) (packetId >> 8), (char) (packetId & 0xFF) };
+  
+  this->lastSentMillis = millis();
+  return this->esp->sendData(this->muxChannel, packet, sizeof(packet));
+}
+
+void ESP8266_MQTT::writeHeader(Print *out, byte header, unsigned long remainingLength)
+{
+  out->write(header);
+  do
+  {
+    out->write((uint8_t) ((remainingLength & 0x7F) | (remainingLength > 0x7F ? 0x80 : 0x00)));
+    remainingLength >>= 7;
+  } while(remainingLength);
+}
+
+// MQTT strings are preceeded by a 2 byte length
+void ESP8266_MQTT::writeString(Print *out, const char *string)
+{
+  unsigned int length = strlen(string);
+  
+  out->write((uint8_t) (length >> 8));
+  out->write((uint8_t) (length & 0xFF));
+  out->write((const uint8_t *) string, length);
+}
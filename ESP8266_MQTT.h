@@ -0,0 +1,156 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266MQTT_h
+#define ESP8266MQTT_h
+
+#include "ESP8266_Simple.h"
+
+// How long to wait for the broker to acknowledge something, and how many
+// times a QoS 1 publish is sent before giving up
+#ifndef ESP8266_MQTT_ACK_TIMEOUT
+  #define ESP8266_MQTT_ACK_TIMEOUT 3000
+#endif
+
+#ifndef ESP8266_MQTT_PUBLISH_ATTEMPTS
+  #define ESP8266_MQTT_PUBLISH_ATTEMPTS 3
+#endif
+
+// Incoming QoS 1 messages are acknowledged after the packet they came in
+// has been read, at most this many per packet
+#ifndef ESP8266_MQTT_MAX_PENDING_ACKS
+  #define ESP8266_MQTT_MAX_PENDING_ACKS 4
+#endif
+
+// MQTT control packet types (the top 4 bits of the fixed header)
+#define ESP8266_MQTT_CONNECT     0x10
+#define ESP8266_MQTT_CONNACK     0x20
+#define ESP8266_MQTT_PUBLISH     0x30
+#define ESP8266_MQTT_PUBACK      0x40
+#define ESP8266_MQTT_SUBSCRIBE   0x80
+#define ESP8266_MQTT_SUBACK      0x90
+#define ESP8266_MQTT_PINGREQ     0xC0
+#define ESP8266_MQTT_PINGRESP    0xD0
+#define ESP8266_MQTT_DISCONNECT  0xE0
+
+// Called for each message received on a subscribed topic, both are null
+// terminated for convenience, a payload bigger than the buffer is truncated
+typedef void (*ESP8266_MQTTMessageHandler)(const char *topic, char *payload, int length);
+
+/**
+ * A minimal MQTT 3.1.1 client, QoS 0 and 1, over one persistent TCP 
+ * connection of an ESP8266_Simple.
+ * 
+ * Incoming data is parsed a few bytes at a time as it is read, so 
+ * messages can be split across packets (or several can be in one packet)
+ * and the only buffer is the one you give for incoming messages.
+ * 
+ * Call loop() as often as possible, it receives messages and keeps the 
+ * connection alive.
+ * 
+ * Note that in the message handler you can't publish() (or anything else 
+ * which sends), ESP8266_BUSY is returned if you try, make a note and do it 
+ * after loop() returns.
+ * 
+ * See the MQTT example for more information.
+ */
+
+class ESP8266_MQTT
+{
+  public:
+    /**
+     * @param esp        The ESP8266, connected to the network already
+     * @param buffer     For incoming messages, topic and payload must fit together
+     * @param bufferSize Of the buffer
+     * @param muxChannel The connection to use, -1 when not in MUX mode
+     */
+    ESP8266_MQTT(ESP8266_Simple *esp, char *buffer, int bufferSize, int muxChannel = -1);
+    
+    void setMessageHandler(ESP8266_MQTTMessageHandler messageHandler);
+    
+    /**
+     * Connect to the broker.
+     * 
+     * @return ESP8266_OK, or an error code (ESP8266_ERROR if the broker refused)
+     */
+    byte connect(unsigned long brokerIpAddress, int port, const char *clientId, const char *username = NULL, const char *password = NULL, unsigned int keepAliveSeconds = 60, byte cleanSession = 1);
+    byte disconnect();
+    byte connected();
+    
+    /**
+     * Publish a message, for QoS 1 this waits for the broker to acknowledge it,
+     * sending it again (up to ESP8266_MQTT_PUBLISH_ATTEMPTS times) if not.
+     */
+    byte publish(const char *topic, const char *payload, int length, byte qos = 0, byte retain = 0);
+    byte publish(const char *topic, const char *payload, byte qos = 0, byte retain = 0);
+    
+    // Subscribe to a topic (wildcards are fine), waits for the broker to acknowledge it
+    byte subscribe(const char *topic, byte qos = 0);
+    
+    // Receive whatever has arrived and keep the connection alive
+    byte loop();
+    
+  protected:
+    byte         receive(unsigned long maxWaitMillis);
+    void         parse(byte c);
+    void         dispatch();
+    byte         waitForAck(byte packetType, unsigned int packetId);
+    byte         sendAck(byte header, unsigned int packetId);
+    void         writeHeader(Print *out, byte header, unsigned long remainingLength);
+    void         writeString(Print *out, const char *string);
+    
+    ESP8266_Simple             *esp;
+    ESP8266_MQTTMessageHandler  messageHandler;
+    char                       *buffer;
+    int                         bufferSize;
+    int                         muxChannel;
+    
+    byte                        isConnected;
+    byte                        receiving;
+    unsigned int                nextPacketId;
+    unsigned int                keepAliveSeconds;
+    unsigned long               lastSentMillis;
+    unsigned long               pingSentMillis;   // 0 = no ping outstanding
+    
+    // The last acknowledgement received
+    byte                        ackType;
+    unsigned int                ackPacketId;
+    byte                        ackReturnCode;
+    
+    // Incremental parser
+    byte                        parseState;
+    byte                        packetHeader;
+    unsigned long               remainingLength;
+    byte                        lengthShift;
+    unsigned long               bodyIndex;
+    
+    unsigned int                pendingAcks[ESP8266_MQTT_MAX_PENDING_ACKS];
+    byte                        numPendingAcks;
+};
+
+#endif
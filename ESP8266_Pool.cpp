@@ -0,0 +1,216 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include "ESP8266_Pool.h"
+
+// GET() and POST() return either an ESP8266_... error code, or an HTTP 
+// response code (or 0 if the server didn't give one), only the former 
+// means the module failed
+#define ESP8266_POOL_IS_FAILURE(code) ((code) > ESP8266_OK && (code) < 100)
+
+ESP8266_Pool::ESP8266_Pool(ESP8266_Simple **modules, byte numModules)
+{
+  this->numModules             = min(numModules, ESP8266_POOL_MAX_MODULES);
+  this->nextModuleIndex        = 0;
+  this->maxConsecutiveFailures = 3;
+  this->retryAfterMillis       = 30000;
+  
+  memset(this->status, 0, sizeof(this->status));
+  for(byte i = 0; i < this->numModules; i++)
+  {
+    this->modules[i] = modules[i];
+  }
+}
+
+void ESP8266_Pool::setHealthThresholds(byte maxConsecutiveFailures, unsigned long retryAfterMillis)
+{
+  this->maxConsecutiveFailures = maxConsecutiveFailures;
+  this->retryAfterMillis       = retryAfterMillis;
+}
+
+#if ESP8266_ENABLE_HTTP_CLIENT
+unsigned int ESP8266_Pool::GET(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, int bodyResponseOnlyFromLine)
+{
+  ESP8266_Simple *module;
+  unsigned int    responseCode = ESP8266_ERROR;
+  
+  // The buffer is over-written even when it fails, so we need to keep the path
+  // for the next try
+  char requestPath[strlen(requestPathAndResponseBuffer)+1];
+  strcpy(requestPath, requestPathAndResponseBuffer);
+  
+  for(byte attempt = 0; attempt < this->numModules; attempt++)
+  {
+    if(!(module = this->nextModule())) break;
+    
+    if(attempt) strcpy(requestPathAndResponseBuffer, requestPath);
+    
+    responseCode = module->GET(serverIp, port, requestPathAndResponseBuffer, bufferLength, httpHost, bodyResponseOnlyFromLine);
+    this->reportResult(module, responseCode);
+    
+    if(!ESP8266_POOL_IS_FAILURE(responseCode)) break;
+  }
+  
+  return responseCode;
+}
+
+unsigned int ESP8266_Pool::POST(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext, long contentLength, int bodyResponseOnlyFromLine)
+{
+  ESP8266_Simple *module;
+  unsigned int    responseCode = ESP8266_ERROR;
+  
+  char requestPath[strlen(requestPathAndResponseBuffer)+1];
+  strcpy(requestPath, requestPathAndResponseBuffer);
+  
+  for(byte attempt = 0; attempt < this->numModules; attempt++)
+  {
+    if(!(module = this->nextModule())) break;
+    
+    if(attempt) strcpy(requestPathAndResponseBuffer, requestPath);
+    
+    responseCode = module->POST(serverIp, port, requestPathAndResponseBuffer, bufferLength, httpHost, contentType, bodyWriter, bodyWriterContext, contentLength, bodyResponseOnlyFromLine);
+    this->reportResult(module, responseCode);
+    
+    if(!ESP8266_POOL_IS_FAILURE(responseCode)) break;
+  }
+  
+  return responseCode;
+}
+
+#endif // ESP8266_ENABLE_HTTP_CLIENT
+
+#if ESP8266_ENABLE_SERVER
+byte ESP8266_Pool::startHttpServer(unsigned port, ESP8266_HttpServerHandler *httpServerHandlers, unsigned int numOfHandlers, unsigned int maxBufferSize, Print *debugPrinter)
+{
+  for(byte i = 0; i < this->numModules; i++)
+  {
+    this->modules[i]->startHttpServer(port, httpServerHandlers, numOfHandlers, maxBufferSize, debugPrinter);
+  }
+  
+  return ESP8266_OK;
+}
+
+byte ESP8266_Pool::serveHttpRequest()
+{
+  byte responseCode = ESP8266_OK;
+  byte moduleResponseCode;
+  
+  for(byte i = 0; i < this->numModules; i++)
+  {
+    if(!this->isHealthy(i)) continue;
+    
+    if((moduleResponseCode = this->modules[i]->serveHttpRequest()) != ESP8266_OK)
+    {
+      this->reportResult(this->modules[i], moduleResponseCode);
+      responseCode = moduleResponseCode;
+    }
+  }
+  
+  return responseCode;
+}
+
+#endif // ESP8266_ENABLE_SERVER
+
+ESP8266_Simple *ESP8266_Pool::nextModule()
+{
+  byte i;
+  
+  // Round robin, skipping any that are down
+  for(byte tried = 0; tried < this->numModules; tried++)
+  {
+    i = this->nextModuleIndex;
+    this->nextModuleIndex = (this->nextModuleIndex + 1) % this->numModules;
+    
+    if(this->isHealthy(i))
+    {
+      this->status[i].requests++;
+      return this->modules[i];
+    }
+  }
+  
+  return NULL;
+}
+
+void ESP8266_Pool::reportResult(ESP8266_Simple *module, unsigned int responseCode)
+{
+  int i = this->moduleIndex(module);
+  if(i < 0) return;
+  
+  if(!ESP8266_POOL_IS_FAILURE(responseCode))
+  {
+    this->status[i].consecutiveFailures = 0;
+    this->status[i].downSinceMillis     = 0;
+    return;
+  }
+  
+  this->status[i].failures++;
+  if(this->status[i].consecutiveFailures < 255) this->status[i].consecutiveFailures++;
+  
+  if(this->status[i].consecutiveFailures >= this->maxConsecutiveFailures)
+  {
+    // (it might already be down and have just failed it's second chance, 
+    //  either way the wait starts again now, millis() of 0 is just bad luck)
+    this->status[i].downSinceMillis = millis() | 1;
+  }
+}
+
+byte ESP8266_Pool::numHealthyModules()
+{
+  byte numHealthy = 0;
+  for(byte i = 0; i < this->numModules; i++)
+  {
+    if(this->isHealthy(i)) numHealthy++;
+  }
+  return numHealthy;
+}
+
+void ESP8266_Pool::getModuleStatus(byte moduleIndex, ESP8266_PoolModuleStatus &status)
+{
+  if(moduleIndex >= this->numModules) 
+  {
+    memset(&status, 0, sizeof(status));
+    return;
+  }
+  
+  memcpy(&status, this->status+moduleIndex, sizeof(status));
+}
+
+int ESP8266_Pool::moduleIndex(ESP8266_Simple *module)
+{
+  for(byte i = 0; i < this->numModules; i++)
+  {
+    if(this->modules[i] == module) return i;
+  }
+  return -1;
+}
+
+// A module is healthy if it is up, or it has been down long enough to 
+// deserve another try
+byte ESP8266_Pool::isHealthy(byte moduleIndex)
+{
+  return !this->status[moduleIndex].downSinceMillis 
+      || (millis() - this->status[moduleIndex].downSinceMillis >= this->retryAfterMillis);
+}
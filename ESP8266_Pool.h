@@ -0,0 +1,123 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266Pool_h
+#define ESP8266Pool_h
+
+#include "ESP8266_Simple.h"
+
+#ifndef ESP8266_POOL_MAX_MODULES
+  #define ESP8266_POOL_MAX_MODULES 4
+#endif
+
+// How a module in the pool is doing
+struct ESP8266_PoolModuleStatus
+{
+    unsigned long requests;             // Requests given to this module
+    unsigned long failures;             // Of those, how many failed
+    byte          consecutiveFailures;  
+    unsigned long downSinceMillis;      // When it was marked down (0 = it's up)
+};
+
+/** 
+ * A pool of several ESP8266 modules (each an ESP8266_Simple of it's own, on 
+ * it's own pins) which are used in turn, so that requests are spread across
+ * them, and if one stops working the others carry on.
+ * 
+ * A module which fails a number of requests in a row is marked down and not
+ * used until some time has passed, then it gets another chance.
+ * 
+ * IMPORTANT: SoftwareSerial can only receive on one port at a time, so while one
+ * module is being talked to, anything the others send is lost.  Making requests 
+ * through the pool is fine (each module only talks when asked), but if you 
+ * serve HTTP requests on more than one module, requests arriving at a module
+ * while another is busy will be missed.
+ * 
+ * See the Pool example for more information.
+ */
+
+class ESP8266_Pool
+{
+  public:
+    /**
+     * @param modules    An array of pointers to the modules, each must have had begin() 
+     *                   and setupAsWifiStation() (or similar) done already
+     * @param numModules How many (at most ESP8266_POOL_MAX_MODULES)
+     */
+    ESP8266_Pool(ESP8266_Simple **modules, byte numModules);
+    
+    /**
+     * A module is marked down after maxConsecutiveFailures failures in a row, and 
+     * tried again after retryAfterMillis.
+     */
+    void setHealthThresholds(byte maxConsecutiveFailures, unsigned long retryAfterMillis);
+    
+#if ESP8266_ENABLE_HTTP_CLIENT
+    /**
+     * As ESP8266_Simple::GET() and POST(), but made through the next healthy 
+     * module, if it fails (that is, the module fails, not the server giving an 
+     * error response) then it is tried on the next, and so on.
+     */
+    unsigned int GET(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost = NULL, int bodyResponseOnlyFromLine = 1);
+    unsigned int POST(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext = NULL, long contentLength = -1, int bodyResponseOnlyFromLine = 1);
+#endif
+    
+#if ESP8266_ENABLE_SERVER
+    /**
+     * Start the same HTTP server on every module, and serve requests from each
+     * in turn (see the note about SoftwareSerial above).
+     */
+    byte startHttpServer(unsigned port, ESP8266_HttpServerHandler *httpServerHandlers, unsigned int numOfHandlers, unsigned int maxBufferSize = 250, Print *debugPrinter = NULL);
+    byte serveHttpRequest();
+#endif
+    
+    /**
+     * Get the next healthy module to use yourself for anything else, tell the
+     * pool how it went with reportResult() so it can keep track of health.  
+     * 
+     * @return The module, or NULL if all are down
+     */
+    ESP8266_Simple *nextModule();
+    void            reportResult(ESP8266_Simple *module, unsigned int responseCode);
+    
+    byte            numHealthyModules();
+    void            getModuleStatus(byte moduleIndex, ESP8266_PoolModuleStatus &status);
+    
+  protected:
+    int             moduleIndex(ESP8266_Simple *module);
+    byte            isHealthy(byte moduleIndex);
+    
+    ESP8266_Simple          *modules[ESP8266_POOL_MAX_MODULES];
+    ESP8266_PoolModuleStatus status[ESP8266_POOL_MAX_MODULES];
+    byte                     numModules;
+    byte                     nextModuleIndex;
+    byte                     maxConsecutiveFailures;
+    unsigned long            retryAfterMillis;
+};
+
+#endif
@@ -0,0 +1,169 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <ctype.h>
+#include "ESP8266_ReplaySerial.h"
+
+ESP8266_ReplaySerial::ESP8266_ReplaySerial(const char *trace, unsigned int timeScalePercent)
+{
+  this->trace            = trace;
+  this->timeScalePercent = timeScalePercent;
+  this->rewind();
+}
+
+void ESP8266_ReplaySerial::setTimeScale(unsigned int timeScalePercent)
+{
+  this->timeScalePercent = timeScalePercent;
+}
+
+void ESP8266_ReplaySerial::rewind()
+{
+  this->mismatchedWrites = 0;
+  this->unexpectedWrites = 0;
+  this->txNeeded         = 0;
+  this->txWritten        = 0;
+  this->lastByteMicros   = micros();
+  
+  this->rxCursor = this->nextRecord(this->trace, 'R', &this->rxGapMicros, &this->rxRemaining);
+  this->txCursor = this->nextRecord(this->trace, 'T', NULL, &this->txRemaining);
+}
+
+byte ESP8266_ReplaySerial::finished()
+{
+  return this->rxCursor == NULL;
+}
+
+// Find the next record in the given direction starting at "from", return a pointer to its
+// first hex byte (or NULL at the end of the trace).  T records which are skipped over 
+// while looking for an R record are added to txNeeded.
+const char *ESP8266_ReplaySerial::nextRecord(const char *from, char direction, unsigned long *gapMicros, int *numBytes)
+{
+  char recordDirection;
+  unsigned long recordGap;
+  int  recordBytes;
+  
+  while(from && *from)
+  {
+    // Skip to the start of a record
+    if(*from != 'T' && *from != 'R') { from++; continue; }
+    
+    recordDirection = *from++;
+    recordGap = 0;
+    while(*from >= '0' && *from <= '9') recordGap = (recordGap * 10) + (*from++ - '0');
+    while(*from == ' ') from++;
+    
+    for(recordBytes = 0; isxdigit(from[recordBytes*2]) && isxdigit(from[recordBytes*2+1]); recordBytes++);
+    
+    if(recordDirection == direction && recordBytes)
+    {
+      if(gapMicros) *gapMicros = recordGap;
+      *numBytes = recordBytes;
+      return from;
+    }
+    
+    if(direction == 'R' && recordDirection == 'T') this->txNeeded += recordBytes;
+    from += recordBytes * 2;
+  }
+  
+  *numBytes = 0;
+  return NULL;
+}
+
+byte ESP8266_ReplaySerial::hexByte(const char *from)
+{
+  byte value = 0;
+  byte i;
+  
+  for(i = 0; i < 2; i++)
+  {
+    value <<= 4;
+    if(from[i] >= 'a')      value |= from[i] - 'a' + 10;
+    else if(from[i] >= 'A') value |= from[i] - 'A' + 10;
+    else                    value |= from[i] - '0';
+  }
+  
+  return value;
+}
+
+size_t ESP8266_ReplaySerial::write(uint8_t byte)
+{
+  if(!this->txCursor)
+  {
+    this->unexpectedWrites++;
+    return 1;
+  }
+  
+  if(this->hexByte(this->txCursor) != byte) this->mismatchedWrites++;
+  
+  this->txCursor += 2;
+  this->txWritten++;
+  this->lastByteMicros = micros();
+  
+  if(!--this->txRemaining)
+  {
+    this->txCursor = this->nextRecord(this->txCursor, 'T', NULL, &this->txRemaining);
+  }
+  
+  return 1;
+}
+
+int ESP8266_ReplaySerial::available()
+{
+  if(!this->rxCursor) return 0;
+  
+  // The ESP8266 wouldn't have said this until we finished saying our bit
+  if(this->txWritten < this->txNeeded) return 0;
+  
+  if(micros() - this->lastByteMicros < (this->rxGapMicros / 100) * this->timeScalePercent) return 0;
+  
+  return this->rxRemaining;
+}
+
+int ESP8266_ReplaySerial::peek()
+{
+  if(!this->available()) return -1;
+  
+  return this->hexByte(this->rxCursor);
+}
+
+int ESP8266_ReplaySerial::read()
+{
+  int c;
+  
+  if(!this->available()) return -1;
+  
+  c = this->hexByte(this->rxCursor);
+  this->rxCursor += 2;
+  this->rxGapMicros    = 0; // the rest of the record came straight after
+  this->lastByteMicros = micros();
+  
+  if(!--this->rxRemaining)
+  {
+    this->rxCursor = this->nextRecord(this->rxCursor, 'R', &this->rxGapMicros, &this->rxRemaining);
+  }
+  
+  return c;
+}
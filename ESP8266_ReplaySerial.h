@@ -0,0 +1,105 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266ReplaySerial_h
+#define ESP8266ReplaySerial_h
+
+#include <Arduino.h>
+
+/**
+ * Plays back a trace captured with ESP8266_Serial::setTracePrinter() as if 
+ * it was the ESP8266, so that a session which went wrong in the field can be
+ * run again (typically on a PC, see ESP8266_REPLAYSERIAL) as often as you like.
+ * 
+ * The trace is text, one record per line, a record is a run of bytes in 
+ * one direction...
+ * 
+ *   T<microseconds since the previous byte> <hex bytes>   (we sent to the ESP8266)
+ *   R<microseconds since the previous byte> <hex bytes>   (we read from the ESP8266)
+ * 
+ * Received bytes are not made available until everything we sent before them
+ * in the trace has been written again, and then the recorded gap has passed
+ * (scaled by timeScalePercent, 100 is the original timing, 200 half speed, 
+ * 0 as fast as possible).
+ * 
+ * Note that received bytes are recorded when they were read out of the 
+ * serial buffer, not when they arrived, so the replay is never earlier
+ * than the original but may be a little later.
+ */
+
+class ESP8266_ReplaySerial : public Stream
+{
+  public:
+    ESP8266_ReplaySerial(const char *trace, unsigned int timeScalePercent = 100);
+    
+    void   begin(long baudRate) { };
+    bool   listen()   { return true;  };
+    bool   overflow() { return false; };
+    
+    void   setTimeScale(unsigned int timeScalePercent);
+    
+    // Start again from the beginning of the trace
+    void   rewind();
+    
+    // True when everything in the trace has been read
+    byte   finished();
+    
+    virtual size_t write(uint8_t byte);
+    virtual int    available();
+    virtual int    read();
+    virtual int    peek();
+    virtual void   flush() { };
+    using Print::write;
+    
+    // How the replay compared with the trace
+    unsigned long mismatchedWrites;   // We wrote something different to the trace
+    unsigned long unexpectedWrites;   // We wrote more than the trace did
+    
+  protected:
+    const char *nextRecord(const char *from, char direction, unsigned long *gapMicros, int *numBytes);
+    byte        hexByte(const char *from);
+    
+    const char   *trace;
+    unsigned int  timeScalePercent;
+    
+    // Reading, walks R records, T records are counted as we pass them so we know
+    // how much needs to be written before the next R record is "sent"
+    const char   *rxCursor;
+    int           rxRemaining;
+    unsigned long rxGapMicros;
+    unsigned long txNeeded;
+    
+    // Writing, walks T records so we can see if we sent the same thing
+    const char   *txCursor;
+    int           txRemaining;
+    unsigned long txWritten;
+    
+    unsigned long lastByteMicros;
+};
+
+#endif
@@ -0,0 +1,116 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include "ESP8266_RetryPolicy.h"
+
+ESP8266_RetryPolicy::ESP8266_RetryPolicy(unsigned int maxAttempts, unsigned long initialDelayMillis, unsigned long maxDelayMillis, byte jitterPercent, unsigned long deadlineMillis)
+{
+  this->maxAttempts        = maxAttempts;
+  this->initialDelayMillis = initialDelayMillis;
+  this->maxDelayMillis     = max(initialDelayMillis, maxDelayMillis);
+  this->jitterPercent      = min(jitterPercent, 100);
+  this->deadlineMillis     = deadlineMillis;
+  
+  this->circuitBreakerThreshold  = 0;
+  this->circuitBreakerOpenMillis = 0;
+  this->consecutiveFailures      = 0;
+  this->circuitOpenedMillis      = 0;
+  
+  this->lastAttempts     = 0;
+  this->lastResponseCode = 0;
+  this->totalAttempts    = 0;
+  this->totalFailures    = 0;
+}
+
+void ESP8266_RetryPolicy::setCircuitBreaker(unsigned int failureThreshold, unsigned long openMillis)
+{
+  this->circuitBreakerThreshold  = failureThreshold;
+  this->circuitBreakerOpenMillis = openMillis;
+}
+
+byte ESP8266_RetryPolicy::isOpen()
+{
+  if(!this->circuitOpenedMillis) return 0;
+  
+  if(millis() - this->circuitOpenedMillis >= this->circuitBreakerOpenMillis)
+  {
+    // Half open, allow a try, if it fails retry() will open it again
+    this->circuitOpenedMillis = 0;
+    return 0;
+  }
+  
+  return 1;
+}
+
+byte ESP8266_RetryPolicy::retry(ESP8266_RetryAttempt &attempt, byte responseCode)
+{
+  unsigned long delayMillis;
+  byte          shift;
+  
+  this->totalAttempts++;
+  this->totalFailures++;
+  this->lastAttempts     = attempt.number;
+  this->lastResponseCode = responseCode;
+  
+  if(this->consecutiveFailures < 0xFFFF) this->consecutiveFailures++;
+  
+  if(this->circuitBreakerThreshold && this->consecutiveFailures >= this->circuitBreakerThreshold)
+  {
+    this->circuitOpenedMillis = millis() | 1; // 0 means closed
+    return 0;
+  }
+  
+  if(this->maxAttempts && attempt.number >= this->maxAttempts) return 0;
+  
+  // Exponential back off, initial, initial*2, initial*4 ... limited to max
+  delayMillis = this->initialDelayMillis;
+  for(shift = 1; shift < attempt.number && delayMillis < this->maxDelayMillis; shift++)
+  {
+    delayMillis = delayMillis << 1;
+  }
+  delayMillis = min(delayMillis, this->maxDelayMillis);
+  
+  if(this->jitterPercent && delayMillis)
+  {
+    long jitterMillis = (long)(delayMillis / 100) * this->jitterPercent;
+    delayMillis += random(-jitterMillis, jitterMillis + 1);
+  }
+  
+  if(this->deadlineMillis && (millis() - attempt.startMillis + delayMillis >= this->deadlineMillis)) return 0;
+  
+  delay(delayMillis);
+  attempt.number++;
+  return 1;
+}
+
+void ESP8266_RetryPolicy::succeeded(ESP8266_RetryAttempt &attempt)
+{
+  this->totalAttempts++;
+  this->lastAttempts        = attempt.number;
+  this->lastResponseCode    = 0;
+  this->consecutiveFailures = 0;
+  this->circuitOpenedMillis = 0;
+}
@@ -0,0 +1,114 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266RetryPolicy_h
+#define ESP8266RetryPolicy_h
+
+#include <Arduino.h>
+
+// Keeps track of one operation being retried (eg, one reset()), create one
+// (on the stack) at the start of the operation
+struct ESP8266_RetryAttempt
+{
+    unsigned int  number;       // 1 for the first attempt, 2 for the first retry...
+    unsigned long startMillis;  // when the operation started
+    
+    ESP8266_RetryAttempt() : number(1), startMillis(millis()) { };
+};
+
+/** 
+ * How to retry something which fails, used by setupAsWifiStation(), reset() 
+ * and startHttpServer() (see ESP8266_Simple::setRetryPolicy()), and you can
+ * use it for your own things too...
+ * 
+ *   ESP8266_RetryAttempt attempt;
+ *   do
+ *   {
+ *     responseCode = doSomething();
+ *   } while(responseCode != ESP8266_OK && policy.retry(attempt, responseCode));
+ * 
+ * The wait between attempts starts at initialDelayMillis and doubles each time 
+ * up to maxDelayMillis, plus or minus up to jitterPercent so that lots of 
+ * devices don't all retry at exactly the same moment (call randomSeed() in
+ * your setup() so they don't all have the same "random" numbers!).
+ * 
+ * If a circuit breaker is set, after that many failures in a row (across all 
+ * operations using this policy) isOpen() is true for openMillis, during which 
+ * things should not be tried at all, afterwards one try is allowed, if it fails 
+ * the breaker opens again straight away.
+ */
+
+class ESP8266_RetryPolicy
+{
+  public:
+    /**
+     * @param maxAttempts        Give up after this many attempts, 0 for never
+     * @param initialDelayMillis Wait this long after the first failure
+     * @param maxDelayMillis     Never wait longer than this
+     * @param jitterPercent      Vary each wait randomly by up to this percent
+     * @param deadlineMillis     Give up if the operation would take longer than this, 0 for never
+     */
+    ESP8266_RetryPolicy(unsigned int maxAttempts = 0, unsigned long initialDelayMillis = 1000, unsigned long maxDelayMillis = 1000, byte jitterPercent = 0, unsigned long deadlineMillis = 0);
+    
+    void setCircuitBreaker(unsigned int failureThreshold, unsigned long openMillis);
+    
+    /**
+     * Record a failed attempt, and if another is allowed wait the appropriate 
+     * time and return 1, otherwise return 0 (give up).
+     */
+    byte retry(ESP8266_RetryAttempt &attempt, byte responseCode);
+    
+    /**
+     * Record that the operation succeeded (retry() is not called when it does).
+     */
+    void succeeded(ESP8266_RetryAttempt &attempt);
+    
+    /**
+     * Is the circuit breaker open (so don't even try)?
+     */
+    byte isOpen();
+    
+    unsigned int  lastAttempts;         // How many attempts the last operation to finish took
+    byte          lastResponseCode;     // And the response code it finished with
+    unsigned long totalAttempts;        // Across all operations
+    unsigned long totalFailures;        
+    
+  protected:
+    unsigned int  maxAttempts;
+    unsigned long initialDelayMillis;
+    unsigned long maxDelayMillis;
+    byte          jitterPercent;
+    unsigned long deadlineMillis;
+    
+    unsigned int  circuitBreakerThreshold;
+    unsigned long circuitBreakerOpenMillis;
+    unsigned int  consecutiveFailures;
+    unsigned long circuitOpenedMillis;
+};
+
+#endif
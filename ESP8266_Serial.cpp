@@ -24,7 +24,6 @@
  */
 #include <Arduino.h>
 #include "ESP8266_Serial.h"
-#include <SoftwareSerial.h>
 
 // as readBytes with terminator character
 // terminates if length characters have been read, timeout, or if the terminator character  detected
@@ -60,3 +59,156 @@ int ESP8266_Serial::waitUntilAvailable(unsigned long maxWaitTime)
   return c;
 }
 
+void ESP8266_Serial::setTracePrinter(Print *tracePrinter)
+{
+  this->tracePrinter   = tracePrinter;
+  this->traceDirection = 0;
+  this->traceMicros    = micros();
+}
+
+void ESP8266_Serial::initialise()
+{
+  this->tracePrinter   = NULL;
+  this->divertChannels = 0;
+  this->diverter       = NULL;
+  this->atLineStart    = 1;
+  this->heldBackLength = 0;
+  this->heldBackIndex  = 0;
+}
+
+void ESP8266_Serial::setPacketDiverter(byte muxChannels, ESP8266_PacketDiverter diverter, void *diverterContext)
+{
+  this->divertChannels  = diverter ? muxChannels : 0;
+  this->diverter        = diverter;
+  this->diverterContext = diverterContext;
+}
+
+size_t ESP8266_Serial::write(uint8_t byte)
+{
+  if(this->tracePrinter) this->traceByte('T', byte);
+  return ESP8266_SerialBase::write(byte);
+}
+
+int ESP8266_Serial::readRaw()
+{
+  int c = ESP8266_SerialBase::read();
+  if(this->tracePrinter && c >= 0) this->traceByte('R', c);
+  return c;
+}
+
+// Bypasses read() so that the packet being diverted is not itself looked into
+int ESP8266_Serial::readRawWait(unsigned long maxWaitMillis)
+{
+  unsigned long startTime = millis();
+  
+  do
+  {
+    if(ESP8266_SerialBase::available()) return this->readRaw();
+  } while(millis() - startTime < maxWaitMillis);
+  
+  return -1;
+}
+
+int ESP8266_Serial::read()
+{
+  int c;
+  
+  if(this->heldBackIndex < this->heldBackLength)
+  {
+    c = this->heldBack[this->heldBackIndex++];
+  }
+  else
+  {
+    // A diverted packet can be followed straight away by another
+    do
+    {
+      c = this->readRaw();
+    } while(c == '+' && this->divertChannels && this->atLineStart && this->divertPacket());
+  }
+  
+  if(c >= 0) this->atLineStart = (c == '\n');
+  return c;
+}
+
+int ESP8266_Serial::available()
+{
+  return (this->heldBackLength - this->heldBackIndex) + ESP8266_SerialBase::available();
+}
+
+// Having read a '+' at the start of a line, see if it is "+IPD,n,length[,ip,port]:"
+// for a diverted channel, if so the packet is given to the diverter and 1 returned, 
+// if not, what was looked at is held back for read() to return after the '+'
+byte ESP8266_Serial::divertPacket()
+{
+  char chunk[16];
+  byte chunkLength;
+  int  c;
+  int  muxChannel;
+  long packetLength = 0;
+  
+  this->heldBack[0]    = '+';
+  this->heldBackLength = 1;
+  this->heldBackIndex  = 1;
+  
+  // The rest of the header follows the + immediately, so we don't wait long 
+  while(this->heldBackLength < 7)
+  {
+    if((c = this->readRawWait(10)) < 0) return 0;
+    
+    this->heldBack[this->heldBackLength++] = c;
+    
+    if(this->heldBackLength <= 5 ? c != pgm_read_byte(PSTR("+IPD,") + this->heldBackLength-1) 
+     : this->heldBackLength == 6 ? !isdigit(c) 
+     : c != ',')
+    {
+      return 0;
+    }
+  }
+  
+  muxChannel = this->heldBack[5] - '0';
+  if(!(this->divertChannels & (1 << muxChannel))) return 0;
+  
+  // It's ours, the length, then perhaps the ip and port (CIPDINFO) up to the :
+  this->heldBackLength = this->heldBackIndex = 0;
+  while((c = this->readRawWait(this->_timeout)) >= 0 && isdigit(c))
+  {
+    packetLength = packetLength * 10 + (c - '0');
+  }
+  while(c >= 0 && c != ':') c = this->readRawWait(this->_timeout);
+  
+  while(c >= 0 && packetLength > 0)
+  {
+    for(chunkLength = 0; chunkLength < sizeof(chunk) && chunkLength < packetLength; chunkLength++)
+    {
+      if((c = this->readRawWait(this->_timeout)) < 0) break;
+      chunk[chunkLength] = c;
+    }
+    
+    if(chunkLength) (*this->diverter)(muxChannel, chunk, chunkLength, this->diverterContext);
+    packetLength -= chunkLength;
+  }
+  
+  this->atLineStart = 1;
+  return 1;
+}
+
+// A new record is started when the direction changes or there is a gap, so
+// a whole response read in one go is a single line in the trace
+void ESP8266_Serial::traceByte(char direction, uint8_t byte)
+{
+  unsigned long now = micros();
+  unsigned long gap = now - this->traceMicros;
+  
+  if(direction != this->traceDirection || gap > ESP8266_TRACE_GAP_MICROSECONDS)
+  {
+    if(this->traceDirection) this->tracePrinter->println();
+    this->tracePrinter->print(direction);
+    this->tracePrinter->print(gap);
+    this->tracePrinter->print(' ');
+    this->traceDirection = direction;
+  }
+  
+  if(byte < 0x10) this->tracePrinter->print('0');
+  this->tracePrinter->print(byte, HEX);
+  this->traceMicros = now;
+}
@@ -29,16 +29,83 @@
 #ifndef ESP8266Serial_h
 #define ESP8266Serial_h
 
-#include <SoftwareSerial.h>
+#ifndef ESP8266_REPLAYSERIAL
+  #define ESP8266_REPLAYSERIAL 2
+#endif
 
-class ESP8266_Serial : public SoftwareSerial
+// Records in a trace are split when there is a gap longer than this between bytes
+#ifndef ESP8266_TRACE_GAP_MICROSECONDS
+  #define ESP8266_TRACE_GAP_MICROSECONDS 2000
+#endif
+
+// When replaying a trace (see ESP8266_ReplaySerial) the ESP8266 is not a SoftwareSerial
+// but is played back from the trace, this needs to be set for the whole build, eg
+// -DESP8266_SERIALMODE=2, it is not enough to #define it in your sketch
+#if defined(ESP8266_SERIALMODE) && ESP8266_SERIALMODE == ESP8266_REPLAYSERIAL
+  #include "ESP8266_ReplaySerial.h"
+  typedef ESP8266_ReplaySerial ESP8266_SerialBase;
+#else
+  #include <SoftwareSerial.h>
+  typedef SoftwareSerial ESP8266_SerialBase;
+#endif
+
+// Given the data of each +IPD packet on a diverted channel (see setPacketDiverter()),
+// a piece at a time, it must not send anything to the ESP8266
+typedef void (*ESP8266_PacketDiverter)(int muxChannel, const char *data, int length, void *context);
+
+class ESP8266_Serial : public ESP8266_SerialBase
 {
   
   public: 
     size_t readBytesUntilAndIncluding(char terminator, char *buffer, size_t length, byte maxOneLineOnly = 0);
     int    waitUntilAvailable(unsigned long maxWaitTime = 1000);
     
-    ESP8266_Serial(short rxPin, short txPin) : SoftwareSerial(rxPin,txPin) { };
+    /**
+     * Record everything sent to and read from the ESP8266 to the given printer,
+     * with timing, in the format which ESP8266_ReplaySerial plays back.  NULL to stop.
+     * 
+     * The printer should be a lot faster than the ESP8266 (each byte is 
+     * written as 2 hex digits), Serial at 115200 is fine for 9600 baud.
+     */
+    void   setTracePrinter(Print *tracePrinter);
+    
+    /**
+     * While set, +IPD packets (in MUX mode) on the channels in the muxChannels
+     * bitmask are taken out of what is read and given to the diverter instead,
+     * so that whatever is reading (a command waiting for it's OK, say) never 
+     * sees them.  0 to stop.
+     */
+    void   setPacketDiverter(byte muxChannels, ESP8266_PacketDiverter diverter, void *diverterContext = NULL);
+    
+    virtual size_t write(uint8_t byte);
+    virtual int    read();
+    virtual int    available();
+    using Print::write;
+    
+#if defined(ESP8266_SERIALMODE) && ESP8266_SERIALMODE == ESP8266_REPLAYSERIAL
+    ESP8266_Serial(const char *trace, unsigned int timeScalePercent = 100) : ESP8266_ReplaySerial(trace, timeScalePercent) { this->initialise(); };
+#else
+    ESP8266_Serial(short rxPin, short txPin) : SoftwareSerial(rxPin,txPin) { this->initialise(); };
+#endif
+
+  protected:
+    void   initialise();
+    void   traceByte(char direction, uint8_t byte);
+    int    readRaw();
+    int    readRawWait(unsigned long maxWaitMillis);
+    byte   divertPacket();
+    
+    Print        *tracePrinter;
+    char          traceDirection;
+    unsigned long traceMicros;
+    
+    byte          divertChannels;     // Bitmask, 0 when not diverting
+    ESP8266_PacketDiverter diverter;
+    void         *diverterContext;
+    byte          atLineStart;        // The last byte read was a \n
+    char          heldBack[8];        // "+IPD,n," looked at by divertPacket() but not diverted
+    byte          heldBackLength;
+    byte          heldBackIndex;      // Next of heldBack to be read()
 };
 
 #endif
\ No newline at end of file
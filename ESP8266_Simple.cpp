@@ -24,7 +24,9 @@
  */
 
 #include <Arduino.h>
+#if !defined(ESP8266_SERIALMODE) || ESP8266_SERIALMODE != 2 // Not when replaying a trace
 #include <SoftwareSerial.h>
+#endif
 // PLEASE NOTE!
 // The Arduino IDE is a bit braindead, even though we include SoftwareSerial.h here, it does nothing
 // you must include SoftwareSerial.h in your main sketch, the Arduino IDE will not include Wire
@@ -33,12 +35,28 @@
 #include "ESP8266_Simple.h"
 #include "ESP8266_Serial.h"
 
+// The profiles for each dialect in ESP8266_DIALECT_... order (less UNKNOWN)
+static const char dialectCIFSR[]    PROGMEM = "AT+CIFSR";
+static const char dialectCIPSTA[]   PROGMEM = "AT+CIPSTA?";
+static const char dialectCIPSTAMAC[] PROGMEM = "AT+CIPSTAMAC?";
+static const char dialectUnlink[]   PROGMEM = "Unlink";
+static const char dialectCLOSED[]   PROGMEM = "CLOSED";
+
+// What a client is told when the server won't take their request (see setServerLimits())
+static const char httpServiceUnavailable[] PROGMEM = "HTTP/1.0 503 Service Unavailable\r\nRetry-After: 1\r\nContent-Length: 0\r\n\r\n";
+
+static const ESP8266_DialectProfile dialectProfiles[] PROGMEM = {
+  { dialectCIFSR,  NULL,             dialectUnlink, 0 },                              // 0.9.2.4
+  { dialectCIPSTA, dialectCIPSTAMAC, dialectCLOSED, ESP8266_FEATURE_UDP_LOCALPORT },  // 0.9.5.2
+  { dialectCIPSTA, dialectCIPSTAMAC, dialectCLOSED, ESP8266_FEATURE_UDP_LOCALPORT | ESP8266_FEATURE_SERVERMAXCONN | ESP8266_FEATURE_IPDINFO | ESP8266_FEATURE_SENDBUF }   // 1.x
+};
+
 #if ESP8266_SERIALMODE == ESP8266_SOFTWARESERIAL
 ESP8266_Simple::ESP8266_Simple(short rxPin, short txPin)
 {
   // this->espSerial = new SoftwareSerial(rxPin,txPin);
   this->espSerial = new ESP8266_Serial(rxPin,txPin);
-  this->generalCommandTimeoutMicroseconds = 2000000;
+  this->initialise();
 }
 #endif
 
@@ -46,14 +64,117 @@ ESP8266_Simple::ESP8266_Simple(short rxPin, short txPin)
 ESP8266_Simple::ESP8266_Simple()
 {
   this->espSerial = &Serial;
-  this->generalCommandTimeoutMicroseconds = 2000000;
+  this->initialise();
+}
+#endif
+
+#if ESP8266_SERIALMODE == ESP8266_REPLAYSERIAL
+ESP8266_Simple::ESP8266_Simple(const char *trace, unsigned int timeScalePercent)
+{
+  this->espSerial = new ESP8266_Serial(trace, timeScalePercent);
+  this->initialise();
 }
 #endif
 
+void ESP8266_Simple::initialise()
+{
+  this->generalCommandTimeoutMicroseconds = 2000000;
+  this->datagramHandler = NULL;
+  this->datagramMaxSize = 0;
+  this->firmwareDialect = ESP8266_DIALECT_UNKNOWN;
+  this->firmwareVersion = 0;
+  this->linkClosed      = 0;
+  this->stationCacheValid        = 0;
+  this->stationCacheMaxAgeMillis = 0;
+  this->retryPolicy              = NULL;
+  this->resetPin                 = -1;
+  this->recovering               = 0;
+  this->consecutiveBusy          = 0;
+  this->consecutiveTimeouts      = 0;
+  this->maxConsecutiveBusy       = 3;
+  this->maxConsecutiveTimeouts   = 3;
+  this->lastResetMillis          = 0;
+  this->packetRemaining          = 0;
+  this->closedChannels           = 0;
+  this->clientChannels           = 0;
+  this->remoteIp                 = 0;
+  this->bodyComplete             = 0;
+  this->pipelinedSends           = 1;
+  this->tcpChannels              = 0;
+  this->pendingSendChannels      = 0;
+  this->failedSendChannels       = 0;
+  memset(this->pendingSends, 0, sizeof(this->pendingSends));
+  memset(&this->recoveryStats, 0, sizeof(this->recoveryStats));
+  
+  this->commandTimeoutMicroseconds[ESP8266_COMMAND_QUICK]   = 2000000UL;
+  this->commandTimeoutMicroseconds[ESP8266_COMMAND_JOIN]    = 20000000UL;
+  this->commandTimeoutMicroseconds[ESP8266_COMMAND_CONNECT] = 5000000UL;
+  this->commandTimeoutMicroseconds[ESP8266_COMMAND_SEND]    = 5000000UL;
+  this->echoState                = ESP8266_ECHO_UNKNOWN;
+  
+#if ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+  this->adaptiveTimeoutPercent   = 0;
+  memset(this->latencySamples, 0, sizeof(this->latencySamples));
+#endif
+  
+#if ESP8266_ENABLE_HTTP_CLIENT
+  this->fetches                  = NULL;
+  this->numFetches               = 0;
+  this->fetchingChannels         = 0;
+#endif
+  
+#if ESP8266_ENABLE_SERVER
+  this->httpServerPort           = 0;
+  this->eventStreamChannels      = 0;
+  this->longPollChannels         = 0;
+  this->capturingRequest         = 0;
+  this->acceptsCbor              = 0;
+  this->ifNoneMatch              = NULL;
+  this->httpAssets               = NULL;
+  this->numHttpAssets            = 0;
+  this->serverChannels           = 0;
+  this->pendingChannels          = 0;
+  this->shedChannels             = 0;
+  this->maxServerConnections     = 0;
+  this->requestDeadlineMillis    = 0;
+  this->serverIdleSeconds        = 180;
+  this->rateLimitMaxRequests     = 0;
+  this->rateLimitWindowSeconds   = 0;
+  memset(&this->serverStats, 0, sizeof(this->serverStats));
+  memset(this->rateLimitClients, 0, sizeof(this->rateLimitClients));
+  this->routeStats               = NULL;
+  this->numRoutes                = 0;
+  this->slowRequests             = NULL;
+  this->numSlowRequests          = 0;
+  this->nextSlowRequest          = 0;
+  this->slowRequestMicros        = 0;
+  this->serverStatusRoute        = NULL;
+  this->dispatchedRoute          = -1;
+  this->dispatchedMicros         = 0;
+#endif
+
+#if ESP8266_ENABLE_WEBSOCKET
+  this->webSocketHandler         = NULL;
+  this->webSocketChannels        = 0;
+  this->webSocketFrameChannel    = -1;
+  this->webSocketUnread          = 0;
+  this->webSocketKey             = NULL;
+#endif
+}
+
 /** Connect to ESP8266 Device */
 byte ESP8266_Simple::begin(long baudRate)
 {  
   this->espSerial->begin(baudRate);  
+  
+  // Nothing we send needs to come back again, if the device isn't answering
+  // yet this is done after the first command it does answer
+  this->disableEcho();
+  
+  // Work out what firmware we are talking to, if the device isn't answering
+  // yet then we will try again when we first need to know
+  this->detectDialect();
+  
   return ESP8266_OK;
 }
 
@@ -70,7 +191,12 @@ byte ESP8266_Simple::setupAsWifiStation(const char *SSID, const char *Password,
     
   byte responseCode;
   
+  // Unless told otherwise, keep trying forever, once a second
+  ESP8266_RetryPolicy  defaultRetryPolicy(0, 1000, 1000);
+  ESP8266_RetryPolicy *retryPolicy = this->retryPolicy ? this->retryPolicy : &defaultRetryPolicy;
+  
   // Reset the ESP8266 Device (soft reset)
+  ESP8266_RetryAttempt resetAttempt;
   do
   { // Keep trying to reset until it works
     if(debugPrinter)
@@ -85,6 +211,7 @@ byte ESP8266_Simple::setupAsWifiStation(const char *SSID, const char *Password,
       {
         debugPrinter->println("OK");
       }
+      retryPolicy->succeeded(resetAttempt);
     }
     else
     {
@@ -92,26 +219,27 @@ byte ESP8266_Simple::setupAsWifiStation(const char *SSID, const char *Password,
       {
         this->debugPrintError(responseCode, debugPrinter);      
       }
-      delay(1000);
     }
-  } while(responseCode != ESP8266_OK);
-  
+  } while(responseCode != ESP8266_OK && retryPolicy->retry(resetAttempt, responseCode));
+  if(responseCode != ESP8266_OK) return responseCode;
   
   
   // Connect To The Wifi Network
+  ESP8266_RetryAttempt connectAttempt;
   do
   { // Keep trying to connect  until it works
     if(debugPrinter)
     {
       debugPrinter->print(F("Connect: "));
     }
-    responseCode = this->connectToWifi(SSID,Password);
+    responseCode = retryPolicy->isOpen() ? ESP8266_CIRCUIT_OPEN : this->connectToWifi(SSID,Password);
     if(responseCode == ESP8266_OK)
     {
       if(debugPrinter)
       {
         debugPrinter->println(F("OK"));
       }              
+      retryPolicy->succeeded(connectAttempt);
     }
     else
     {
@@ -119,12 +247,13 @@ byte ESP8266_Simple::setupAsWifiStation(const char *SSID, const char *Password,
       {
         this->debugPrintError(responseCode, debugPrinter);      
       }
-      delay(1000);
     }
-  } while(responseCode != ESP8266_OK);
+  } while(responseCode != ESP8266_OK && responseCode != ESP8266_CIRCUIT_OPEN && retryPolicy->retry(connectAttempt, responseCode));
+  if(responseCode != ESP8266_OK) return responseCode;
   
   // Print Our IP Address
   char ipAddressString[16];
+  ESP8266_RetryAttempt ipAttempt;
   do
   { // Keep trying to connect  until it works
     if(debugPrinter)
@@ -138,6 +267,7 @@ byte ESP8266_Simple::setupAsWifiStation(const char *SSID, const char *Password,
       {
         debugPrinter->println(ipAddressString);                
       }      
+      retryPolicy->succeeded(ipAttempt);
     }
     else
     {
@@ -145,14 +275,18 @@ byte ESP8266_Simple::setupAsWifiStation(const char *SSID, const char *Password,
       {
         this->debugPrintError(responseCode, debugPrinter);      
       }      
-      delay(1000);
     }
-  } while(responseCode != ESP8266_OK);
+  } while(responseCode != ESP8266_OK && retryPolicy->retry(ipAttempt, responseCode));
 
-  
-  return 1;
+  return responseCode;
+}
+
+void ESP8266_Simple::setRetryPolicy(ESP8266_RetryPolicy *retryPolicy)
+{
+  this->retryPolicy = retryPolicy;
 }
 
+#if ESP8266_ENABLE_HTTP_CLIENT
 unsigned int ESP8266_Simple::GET(const __FlashStringHelper *serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, int bodyResponseOnlyFromLine)
 {
   if(!serverIp)                       return ESP8266_ERROR;
@@ -169,9 +303,6 @@ unsigned int ESP8266_Simple::GET(unsigned long serverIp, int port, char *request
   if(!serverIp)                       return ESP8266_ERROR;
   if(!requestPathAndResponseBuffer)   return ESP8266_ERROR;
   
-  char serverIpBuffer[strlen_P((const char *)serverIp)+1];
-  strcpy_P(serverIpBuffer, (const char *) serverIp); 
-  
   int  httpResponseCode = 0;
   byte responseCode;
   
@@ -194,26 +325,104 @@ unsigned int ESP8266_Simple::GET(unsigned long serverIp, int port, char *request
   return httpResponseCode;
 }
 
+unsigned int ESP8266_Simple::POST(const __FlashStringHelper *serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext, long contentLength, int bodyResponseOnlyFromLine)
+{
+  if(!serverIp)                       return ESP8266_ERROR;
+  char serverIpBuffer[strlen_P((const char *)serverIp)+1];
+  strcpy_P(serverIpBuffer, (const char *) serverIp); 
+  
+  unsigned long serverIpLong;
+  this->ipConvertDatatypeFromTo(serverIpBuffer, serverIpLong);
+  return this->sendHttpRequestWithBody(PSTR("POST"), serverIpLong, port, requestPathAndResponseBuffer, bufferLength, httpHost, contentType, bodyWriter, bodyWriterContext, contentLength, bodyResponseOnlyFromLine);
+}
+
+unsigned int ESP8266_Simple::POST(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext, long contentLength, int bodyResponseOnlyFromLine)
+{
+  return this->sendHttpRequestWithBody(PSTR("POST"), serverIp, port, requestPathAndResponseBuffer, bufferLength, httpHost, contentType, bodyWriter, bodyWriterContext, contentLength, bodyResponseOnlyFromLine);
+}
+
+unsigned int ESP8266_Simple::PUT(const __FlashStringHelper *serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext, long contentLength, int bodyResponseOnlyFromLine)
+{
+  if(!serverIp)                       return ESP8266_ERROR;
+  char serverIpBuffer[strlen_P((const char *)serverIp)+1];
+  strcpy_P(serverIpBuffer, (const char *) serverIp); 
+  
+  unsigned long serverIpLong;
+  this->ipConvertDatatypeFromTo(serverIpBuffer, serverIpLong);
+  return this->sendHttpRequestWithBody(PSTR("PUT"), serverIpLong, port, requestPathAndResponseBuffer, bufferLength, httpHost, contentType, bodyWriter, bodyWriterContext, contentLength, bodyResponseOnlyFromLine);
+}
+
+unsigned int ESP8266_Simple::PUT(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext, long contentLength, int bodyResponseOnlyFromLine)
+{
+  return this->sendHttpRequestWithBody(PSTR("PUT"), serverIp, port, requestPathAndResponseBuffer, bufferLength, httpHost, contentType, bodyWriter, bodyWriterContext, contentLength, bodyResponseOnlyFromLine);
+}
+
+unsigned int ESP8266_Simple::sendHttpRequestWithBody(const char *method, unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext, long contentLength, int bodyResponseOnlyFromLine)
+{
+  if(!serverIp)                       return ESP8266_ERROR;
+  if(!requestPathAndResponseBuffer)   return ESP8266_ERROR;
+  
+  int  httpResponseCode = 0;
+  byte responseCode;
+  
+  // The strings all need to be in RAM for sendHttpRequest()
+  char httpHostBuffer[httpHost ? strlen_P((const char *)httpHost)+1 : 1];
+  char contentTypeBuffer[contentType ? strlen_P((const char *)contentType)+1 : 1];
+  
+  httpHostBuffer[0]    = 0;
+  contentTypeBuffer[0] = 0;
+  if(httpHost)    strcpy_P(httpHostBuffer,    (const char *)httpHost);
+  if(contentType) strcpy_P(contentTypeBuffer, (const char *)contentType);
+  
+  ESP8266_HttpRequest request;
+  request.method            = method;
+  request.contentType       = contentTypeBuffer[0] ? contentTypeBuffer : NULL;
+  request.bodyWriter        = bodyWriter;
+  request.bodyWriterContext = bodyWriterContext;
+  request.contentLength     = contentLength;
+  
+  responseCode = this->sendHttpRequest(serverIp, port, requestPathAndResponseBuffer, bufferLength, httpHostBuffer[0] ? httpHostBuffer : NULL, &request, bodyResponseOnlyFromLine, &httpResponseCode);
+  
+  if(responseCode != ESP8266_OK)
+  {
+    return responseCode;
+  }
+  
+  return httpResponseCode;
+}
+#endif // ESP8266_ENABLE_HTTP_CLIENT
+
 /** Reset the device (soft reset) */
 byte ESP8266_Simple::reset()
 {   
-  byte remainingAttempts = 5;
+  byte responseCode;
+  
+  // Unless told otherwise, try 5 times, once a second
+  ESP8266_RetryPolicy  defaultRetryPolicy(5, 1000, 1000);
+  ESP8266_RetryPolicy *retryPolicy = this->retryPolicy ? this->retryPolicy : &defaultRetryPolicy;
+  
+  this->invalidateStationCache();
+  this->lastResetMillis = millis();
+  
+  if(retryPolicy->isOpen()) return ESP8266_CIRCUIT_OPEN;
   
-  while ( this->sendCommand(F("AT+RST")) != ESP8266_OK )
+  ESP8266_RetryAttempt resetAttempt;
+  while ( (responseCode = this->sendCommand(F("AT+RST"))) != ESP8266_OK )
   {
-    if(--remainingAttempts == 0) return ESP8266_ERROR;
-    delay(1000);    
+    if(!retryPolicy->retry(resetAttempt, responseCode)) return ESP8266_ERROR;
   }
-  remainingAttempts = 5;
+  retryPolicy->succeeded(resetAttempt);
+  this->echoState = ESP8266_ECHO_UNKNOWN;
   
   // delay(4000);
   // Once the reset is issued OK, try to issue an AT command
   // and wait until that works
-  while ( this->sendCommand("AT") != ESP8266_OK )
+  ESP8266_RetryAttempt atAttempt;
+  while ( (responseCode = this->sendCommand("AT")) != ESP8266_OK )
   {
-    if(--remainingAttempts == 0) return ESP8266_ERROR;
-    delay(1000);    
+    if(!retryPolicy->retry(atAttempt, responseCode)) return ESP8266_ERROR;
   }
+  retryPolicy->succeeded(atAttempt);
   
   ESP82336_DEBUGLN("RESET OK");
   
@@ -221,58 +430,135 @@ byte ESP8266_Simple::reset()
 }
 
 byte ESP8266_Simple::getFirmwareVersion(long &versionResponse)
+{
+  byte responseCode;
+  
+  if(this->firmwareDialect == ESP8266_DIALECT_UNKNOWN)
+  {
+    if((responseCode = this->detectDialect()) != ESP8266_OK) return responseCode;
+  }
+  
+  versionResponse = this->firmwareVersion;
+  return ESP8266_OK;
+}
+
+byte ESP8266_Simple::getFirmwareDialect()
+{
+  if(this->firmwareDialect == ESP8266_DIALECT_UNKNOWN)
+  {
+    this->detectDialect();
+  }
+  
+  return this->firmwareDialect;
+}
+
+// Ask the device for it's version (once) and from that decide which dialect
+// it speaks
+byte ESP8266_Simple::detectDialect()
 {
   // 0.9.2.4 returns just a single value
+  //  0018000902-AI03
   // 0.9.5.2 returns 
-  //  AT version:0.21.0.0
+  //  AT version:0.21.0.0
   //  SDK version:0.9.5 <--- Notice there is no .2 !
+  // 1.x returns
+  //  AT version:0.40.0.0(Jun  5 2015 16:27:16)
+  //  SDK version:1.1.1
+  //  Ai-Thinker Technology Co. Ltd.
+  //  Jun  5 2015 23:07:20
+  
+  char buffer[64] = { 0 };
+  char *sdkVersion;
+  byte responseCode;
+  byte numParts;
   
-  char buffer[32] = { 0 };
+  responseCode = this->sendCommand(F("AT+GMR"), buffer, sizeof(buffer)); 
+  if(responseCode != ESP8266_OK) return responseCode;
   
-  byte responseCode;
-  versionResponse = 0;
-  
-  // This handles 0.9.5.2
-  //  each part is encoded to 8 bytes and put into the 32 bit long
-  //  
-  //  IE 0.9.5 becomes
-  //  
-  responseCode = this->sendCommand(F("AT+GMR"), buffer, sizeof(buffer), 2); 
-  if(responseCode == ESP8266_OK)
-  {    
-    buffer[sizeof(buffer)-1] = 0; // Ensure string is terminated
-    if(buffer[11] == ':')
+  buffer[sizeof(buffer)-1] = 0; // Ensure string is terminated
+  
+  if(strncmp_P(buffer, PSTR("AT version:"), 11) == 0)
+  {
+    // The SDK version is used, each part is encoded to 8 bits and put into
+    // the 32 bit long, IE 0.9.5 becomes 0x00090500
+    if(!(sdkVersion = strstr_P(buffer, PSTR("SDK version:")))) return ESP8266_ERROR;
+    sdkVersion += 12;
+    
+    this->firmwareVersion = 0;
+    for(numParts = 0; numParts < 4; numParts++)
     {
-      responseCode = 0; // Reuse this for number of bytes
-      
-      for(byte i = 12; i < sizeof(buffer); i++) 
-      {   
-        versionResponse = (versionResponse<<8) | atol(buffer+i);        
-        responseCode++;
-        while(buffer[++i] != '.')
-        {
-          if(i >= sizeof(buffer)) break;
-        }
-      }
-      
-      while(responseCode < 4) 
-      { 
-        versionResponse = versionResponse << 8; 
-        responseCode++;       
-      }
+      this->firmwareVersion = (this->firmwareVersion << 8) | atol(sdkVersion);
+      while(*sdkVersion >= '0' && *sdkVersion <= '9') sdkVersion++;
+      if(*sdkVersion == '.') sdkVersion++; // and the rest of the parts are 0 if there is not a dot
     }
-      
-    if(versionResponse > 0) return ESP8266_OK;
+    
+    this->firmwareDialect = this->firmwareVersion >= 0x01000000 ? ESP8266_DIALECT_1X : ESP8266_DIALECT_0952;
   }
+  else
+  {
+    this->firmwareVersion = atol(buffer);
+    this->firmwareDialect = ESP8266_DIALECT_0924;
+  }
+  
+  return ESP8266_OK;
+}
+
+// Is this (a line from the device) the dialect's connection closed notice, it 
+// might be preceeded by the mux channel, eg "0,CLOSED", if we don't know the 
+// dialect we accept any of them
+byte ESP8266_Simple::isClosedResponse(const char *line)
+{
+  if(line[0] >= '0' && line[0] <= '9' && line[1] == ',') line += 2;
   
-  // This should do 0.9.2.4
-  responseCode = this->sendCommand(F("AT+GMR"), buffer, sizeof(buffer));
-  if(responseCode == ESP8266_OK)
+  if(this->firmwareDialect == ESP8266_DIALECT_UNKNOWN)
   {
-    buffer[sizeof(buffer)-1] = 0; // Ensure string is terminated after 10 characters
-    versionResponse = atol(buffer);        
+    return strncmp_P(line, dialectUnlink, 6) == 0 || strncmp_P(line, dialectCLOSED, 6) == 0;
   }
-  return responseCode;
+  
+  const char *closedResponse = (const char *) pgm_read_word(&dialectProfiles[this->firmwareDialect-1].closedResponse);
+  return strncmp_P(line, closedResponse, strlen_P(closedResponse)) == 0;
+}
+
+// If the firmware we are talking to can do something (ESP8266_FEATURE_...)
+byte ESP8266_Simple::hasFeature(byte feature)
+{
+  if(this->getFirmwareDialect() == ESP8266_DIALECT_UNKNOWN) return 0;
+  
+  return (pgm_read_byte(&dialectProfiles[this->firmwareDialect-1].features) & feature) ? 1 : 0;
+}
+
+// The numbers after "+IPD," are [mux,]length[,ip,port] depending if we are
+// in MUX mode and if CIPDINFO is on, how many there are tells us which, 
+// returns the mux channel (-1 if none) and remembers the ip in remoteIp
+int ESP8266_Simple::parseIPD(const char *fields, int &packetLength)
+{
+  const char *field[4];
+  byte numFields = 1;
+  int  muxChannel = -1;
+  
+  field[0] = fields;
+  for(; *fields && *fields != ':' && numFields < 4; fields++)
+  {
+    if(*fields == ',') field[numFields++] = fields+1;
+  }
+  
+  if(numFields == 2 || numFields == 4)
+  {
+    muxChannel   = atoi(field[0]);
+    packetLength = atoi(field[1]);
+  }
+  else
+  {
+    packetLength = atoi(field[0]);
+  }
+  
+  this->remoteIp = 0;
+  if(numFields >= 3)
+  {
+    this->ipConvertDatatypeFromTo(field[numFields-2] + (*field[numFields-2] == '"' ? 1 : 0), this->remoteIp);
+  }
+  
+  return muxChannel;
 }
 
 byte ESP8266_Simple::setWifiMode(byte mode)
@@ -280,6 +566,7 @@ byte ESP8266_Simple::setWifiMode(byte mode)
   char modeBuff[12];
   strcpy_P(modeBuff, PSTR("AT+CWMODE="));
   itoa((int)mode,modeBuff+10,10);
+  this->invalidateStationCache();
   return this->sendCommand(modeBuff);
 }
 
@@ -288,13 +575,125 @@ byte ESP8266_Simple::getAccessPointsList(char *buffer, int bufferSize )
   return this->sendCommand(F("AT+CWLAP"), buffer, bufferSize);  
 }
 
+byte ESP8266_Simple::scanAccessPoints(ESP8266_AccessPointHandler accessPointHandler, ESP8266_AccessPoint *strongest, byte numStrongest, const char *onlySSID, unsigned int *numFound)
+{
+  char lineBuffer[96];
+  int  bytesRead;
+  byte i;
+  ESP8266_AccessPoint accessPoint;
+  
+  if(numFound) *numFound = 0;
+  for(i = 0; i < numStrongest; i++)
+  {
+    memset(strongest+i, 0, sizeof(ESP8266_AccessPoint));
+    strongest[i].rssi = -128;
+  }
+  
+  // We don't use sendCommand() because we want to deal with each line as it 
+  // comes rather than collect them all into a buffer
+  this->clearSerialBuffer();
+  this->espSerial->print(F("AT+CWLAP"));
+  if(onlySSID)
+  {
+    this->espSerial->print(F("=\""));
+    this->espSerial->print(onlySSID);
+    this->espSerial->print('"');
+  }
+  this->espSerial->println();
+  
+  // A scan takes a few seconds, not learnt from as it is nothing like a join
+  ESP8266_Deadline deadline(this->commandTimeoutMicroseconds[ESP8266_COMMAND_JOIN]);
+  do
+  {
+    if(!this->espSerial->available()) continue;
+    
+    memset(lineBuffer,0,sizeof(lineBuffer));
+    if(!(bytesRead = this->espSerial->readBytesUntil('\n',lineBuffer,sizeof(lineBuffer)-1))) continue;
+    ESP82336_DEBUGLN(lineBuffer);
+    
+    if(strncmp_P(lineBuffer, PSTR("OK"),    2) == 0) return ESP8266_OK;
+    if(strncmp_P(lineBuffer, PSTR("ERROR"), 5) == 0) return ESP8266_ERROR;
+    if(strncmp_P(lineBuffer, PSTR("busy"),  4) == 0) return ESP8266_BUSY;
+    this->noteUnsolicited(lineBuffer);
+    
+    if(!this->parseAccessPoint(lineBuffer, &accessPoint)) continue;
+    
+    if(numFound) (*numFound)++;
+    if(accessPointHandler) accessPointHandler(&accessPoint);
+    
+    // Insert into the strongest list (if it's strong enough)
+    for(i = 0; i < numStrongest; i++)
+    {
+      if(accessPoint.rssi > strongest[i].rssi || !strongest[i].ssid[0])
+      {
+        memmove(strongest+i+1, strongest+i, (numStrongest-i-1) * sizeof(ESP8266_AccessPoint));
+        memcpy(strongest+i, &accessPoint, sizeof(ESP8266_AccessPoint));
+        break;
+      }
+    }
+  } while(!deadline.expired());
+  
+  return ESP8266_TIMEOUT;
+}
+
+// Parse a line like 
+//   +CWLAP:(3,"MyNetwork",-64,"18:fe:34:00:00:00",6)
+// returns 0 if it isn't one of those
+byte ESP8266_Simple::parseAccessPoint(char *line, ESP8266_AccessPoint *accessPoint)
+{
+  char *ssidEnd;
+  byte  i;
+  
+  if(strncmp_P(line, PSTR("+CWLAP:("), 8) != 0) return 0;
+  line += 8;
+  
+  memset(accessPoint, 0, sizeof(ESP8266_AccessPoint));
+  accessPoint->encryption = atoi(line);
+  
+  if(!(line = strchr(line, '"'))) return 0;
+  line++;
+  
+  // An SSID can contain anything, even quotes and commas, but the RSSI is 
+  // always negative so ", followed by - is the best bet for the end of it
+  if(!(ssidEnd = strstr_P(line, PSTR("\",-"))) && !(ssidEnd = strstr_P(line, PSTR("\","))))  return 0;
+  memcpy(accessPoint->ssid, line, min(ssidEnd - line, (int)sizeof(accessPoint->ssid)-1));
+  line = ssidEnd + 2;
+  
+  accessPoint->rssi = atoi(line);
+  
+  if((line = strchr(line, '"')))
+  {
+    for(i = 0; i < 6; i++)
+    {
+      accessPoint->mac[i] = strtoul(line+1, &line, 16);
+    }
+    
+    if((line = strchr(line, ',')))
+    {
+      accessPoint->channel = atoi(line+1);
+    }
+  }
+  
+  return 1;
+}
+
 byte ESP8266_Simple::getIPAddress(unsigned long &ipAddress)
 {
   char buffer[16]; // [3].[3].[3].[3][NUL]
   byte errCode;
-    
-  errCode     = this->sendCommand(F("AT+CIPSTA?"), buffer, sizeof(buffer)); // 0.9.5.2
-  if(errCode) 
+  
+  if(this->stationCacheIsValid(ESP8266_CACHE_IP))
+  {
+    ipAddress = this->stationIp;
+    return ESP8266_OK;
+  }
+  
+  if(this->getFirmwareDialect() != ESP8266_DIALECT_UNKNOWN)
+  {
+    errCode   = this->sendCommand((const __FlashStringHelper *) pgm_read_word(&dialectProfiles[this->firmwareDialect-1].ipAddressCommand), buffer, sizeof(buffer));
+    if(errCode) return errCode;
+  }
+  else if((errCode = this->sendCommand(F("AT+CIPSTA?"), buffer, sizeof(buffer)))) // 0.9.5.2
   {
     errCode     = this->sendCommand(F("AT+CIFSR"), buffer, sizeof(buffer)); // 0.9.2.4
     if(errCode)
@@ -305,6 +704,13 @@ byte ESP8266_Simple::getIPAddress(unsigned long &ipAddress)
   
   this->ipConvertDatatypeFromTo(buffer, ipAddress);
   
+  // No IP yet (0.0.0.0) is not worth remembering, we want to ask again
+  if(ipAddress)
+  {
+    this->stationIp = ipAddress;
+    this->stationCacheFilled(ESP8266_CACHE_IP);
+  }
+  
   return ESP8266_OK;
 }
 
@@ -319,59 +725,361 @@ byte ESP8266_Simple::getIPAddress(char * ipAddress)
   return ESP8266_OK;
 }
 
-byte ESP8266_Simple::setTimeout(int seconds)
+byte ESP8266_Simple::getMACAddress(char *macAddress)
 {
-  this->generalCommandTimeoutMicroseconds = seconds * 1000 * 1000;
+  char buffer[18]; // xx:xx:xx:xx:xx:xx[NUL]
+  byte errCode;
+  byte i;
+  
+  if(!this->stationCacheIsValid(ESP8266_CACHE_MAC))
+  {
+    if(this->getFirmwareDialect() == ESP8266_DIALECT_UNKNOWN)                                 return ESP8266_ERROR;
+    if(!pgm_read_word(&dialectProfiles[this->firmwareDialect-1].macAddressCommand))          return ESP8266_ERROR;
+    
+    errCode = this->sendCommand((const __FlashStringHelper *) pgm_read_word(&dialectProfiles[this->firmwareDialect-1].macAddressCommand), buffer, sizeof(buffer));
+    if(errCode) return errCode;
+    
+    for(i = 0; i < 6; i++)
+    {
+      this->stationMac[i] = strtoul(buffer + (i*3), NULL, 16);
+    }
+    this->stationCacheFilled(ESP8266_CACHE_MAC);
+  }
+  
+  memset(macAddress, 0, 18);
+  for(i = 0; i < 6; i++)
+  {
+    if(i) macAddress[strlen(macAddress)] = ':';
+    if(this->stationMac[i] < 0x10) macAddress[strlen(macAddress)] = '0';
+    utoa(this->stationMac[i], macAddress+strlen(macAddress), 16);
+  }
   
   return ESP8266_OK;
 }
 
-long ESP8266_Simple::connectToWifi(const char *SSID, const char *Password)
+byte ESP8266_Simple::getConnectedSSID(char *ssid, int ssidBufferSize)
 {
-  byte returnValue;
-  unsigned long previousTimeout = this->generalCommandTimeoutMicroseconds;
-  
-  // First set to client mode
-  returnValue = this->setWifiMode(ESP8266_STATION);
-  if(returnValue != ESP8266_OK) return returnValue;
+  byte errCode;
+  char *endQuote;
   
-  // Not sure if a QAP is a good idea here?
-  /*
-    returnValue = this->disconnectFromWifi();
-    if(returnValue != ESP8266_OK) return returnValue;
-  */
+  if(!this->stationCacheIsValid(ESP8266_CACHE_SSID))
+  {
+    // Comes back as +CWJAP:"ssid", or on 1.x +CWJAP:"ssid","bssid",channel,rssi
+    errCode = this->sendCommand(F("AT+CWJAP?"), this->stationSsid, sizeof(this->stationSsid));
+    if(errCode) return errCode;
+    
+    if((endQuote = strchr(this->stationSsid, '"')))  *endQuote = 0;
+    if((endQuote = strchr(this->stationSsid, '\r'))) *endQuote = 0;
+    if((endQuote = strchr(this->stationSsid, '\n'))) *endQuote = 0;
+    
+    // "No AP" means we are not connected, nothing to remember then
+    if(!this->stationSsid[0] || strncmp_P(this->stationSsid, PSTR("No AP"), 5) == 0)
+    {
+      memset(ssid, 0, ssidBufferSize);
+      return ESP8266_ERROR;
+    }
+    this->stationCacheFilled(ESP8266_CACHE_SSID);
+  }
   
+  memset(ssid, 0, ssidBufferSize);
+  strncpy(ssid, this->stationSsid, ssidBufferSize-1);
+  return ESP8266_OK;
+}
+
+byte ESP8266_Simple::getLinkStatus(byte &linkStatus)
+{
+  char buffer[12]; // STATUS:n
+  byte errCode;
   
-  char atCmd[11];
-  strcpy_P(atCmd, PSTR("AT+CWJAP=\"")); // PSTR monkeying to save a few bytes
-  const char *cmdParts[] = {
-    atCmd,
-    SSID,
-    "\",\"",
-    Password,
-    "\""
-  };
+  if(!this->stationCacheIsValid(ESP8266_CACHE_STATUS))
+  {
+    errCode = this->sendCommand(F("AT+CIPSTATUS"), buffer, sizeof(buffer));
+    if(errCode) return errCode;
+    
+    if(strncmp_P(buffer, PSTR("STATUS:"), 7) != 0) return ESP8266_ERROR;
+    
+    this->stationLinkStatus = atoi(buffer+7);
+    this->stationCacheFilled(ESP8266_CACHE_STATUS);
+  }
   
-  // Connecting to Wifi takes a while
-  this->generalCommandTimeoutMicroseconds = max((long)5*1000*1000, this->generalCommandTimeoutMicroseconds);
-
-  returnValue = this->sendCommand((const char **)cmdParts,(byte)5, (char *)NULL,(int)0, (byte)1);
-  this->generalCommandTimeoutMicroseconds = previousTimeout;
-  return returnValue;
+  linkStatus = this->stationLinkStatus;
+  return ESP8266_OK;
 }
 
-byte ESP8266_Simple::disconnectFromWifi()
+void ESP8266_Simple::setStationCacheMaxAge(unsigned long maxAgeMillis)
 {
-  return this->sendCommand(F("AT+CWQAP"));  
+  this->stationCacheMaxAgeMillis = maxAgeMillis;
 }
 
-byte ESP8266_Simple::startHttpServer(unsigned port, ESP8266_HttpServerHandler *httpServerHandlersArg, unsigned int numOfHandlers, unsigned int maxBufferSize, Print *debugPrinter) 
+void ESP8266_Simple::invalidateStationCache(byte whichParts)
+{
+  this->stationCacheValid &= ~whichParts;
+}
+
+byte ESP8266_Simple::stationCacheIsValid(byte whichPart)
+{
+  if(this->stationCacheValid && this->stationCacheMaxAgeMillis && (millis() - this->stationCacheMillis > this->stationCacheMaxAgeMillis))
+  {
+    this->stationCacheValid = 0;
+  }
+  
+  return this->stationCacheValid & whichPart;
+}
+
+void ESP8266_Simple::stationCacheFilled(byte whichPart)
+{
+  if(!this->stationCacheValid) 
+  {
+    this->stationCacheMillis = millis();
+  }
+  this->stationCacheValid |= whichPart;
+}
+
+// Lines the device sends on it's own which mean something about the station
+// has changed (or it rebooted), so whatever we remember is out of date
+void ESP8266_Simple::noteUnsolicited(const char *line)
+{
+  const char *sent;
+  
+  if(line[0] == 'W' && strncmp_P(line, PSTR("WIFI "), 5) == 0)
+  {
+    // WIFI CONNECTED, WIFI GOT IP, WIFI DISCONNECT
+    this->invalidateStationCache();
+  }
+  else if(line[0] == 'r' && strncmp_P(line, PSTR("ready"), 5) == 0)
+  {
+    this->invalidateStationCache();
+    this->echoState           = ESP8266_ECHO_UNKNOWN;
+    this->clientChannels      = 0;
+    this->tcpChannels         = 0;
+    this->pendingSendChannels = 0;
+    memset(this->pendingSends, 0, sizeof(this->pendingSends));
+#if ESP8266_ENABLE_SERVER
+    this->serverChannels      = 0;
+    this->pendingChannels     = 0;
+    this->shedChannels        = 0;
+    this->eventStreamChannels = 0;
+    this->longPollChannels    = 0;
+#endif
+#if ESP8266_ENABLE_WEBSOCKET
+    this->webSocketChannels   = 0;
+#endif
+  }
+  else if(line[0] && line[1] == ',' && this->isClosedResponse(line))
+  {
+    // "n,CLOSED", the other end went away
+    this->channelClosed(line[0] - '0');
+  }
+  else if((this->pendingSendChannels & (1 << ESP8266_MUX_CHANNELS)) && this->isClosedResponse(line))
+  {
+    // "CLOSED" with segments still queued on the single connection, they won't go
+    this->linkClosed = 1;
+    this->pendingSends[ESP8266_MUX_CHANNELS] = 0;
+    this->pendingSendChannels &= ~(1 << ESP8266_MUX_CHANNELS);
+  }
+#if ESP8266_ENABLE_SERVER
+  else if(line[0] && line[1] == ',' && strncmp_P(line+2, PSTR("CONNECT"), 7) == 0 && (line[9] == '\r' || !line[9]))
+  {
+    // "n,CONNECT", a client connected to the server (or we connected somewhere)
+    this->channelOpened(line[0] - '0');
+  }
+#endif
+  else if(this->pendingSendChannels && isdigit(line[0]) && (sent = strstr_P(line, PSTR(",SEND "))))
+  {
+    // "n,segment,SEND OK" (or SEND FAIL) in MUX mode, "segment,SEND OK" when 
+    // not, an AT+CIPSENDBUF segment went
+    this->segmentSent(strchr(line, ',') < sent ? line[0] - '0' : -1, sent[6] == 'O');
+  }
+}
+
+#if ESP8266_ENABLE_SERVER
+void ESP8266_Simple::channelOpened(int muxChannel)
+{
+  byte count = 0;
+  
+  if(muxChannel < 0 || muxChannel >= ESP8266_MUX_CHANNELS) return;
+  if(this->clientChannels & (1 << muxChannel)) return; // We opened it
+  
+  this->closedChannels  &= ~(1 << muxChannel);
+  this->serverChannels  |= (1 << muxChannel);
+  this->pendingChannels |= (1 << muxChannel);
+  this->channelOpenedMillis[muxChannel] = millis();
+  
+  // We can't say anything now (we are in the middle of reading), it gets 
+  // it's 503 next time serveHttpRequest() has nothing else to do
+  for(byte channels = this->serverChannels; channels; channels >>= 1)
+  {
+    if(channels & 1) count++;
+  }
+  if(this->maxServerConnections && count > this->maxServerConnections)
+  {
+    this->shedChannels |= (1 << muxChannel);
+  }
+}
+#endif // ESP8266_ENABLE_SERVER
+
+void ESP8266_Simple::channelClosed(int muxChannel)
+{
+  if(muxChannel < 0 || muxChannel >= ESP8266_MUX_CHANNELS) return;
+  
+  this->closedChannels      |= (1 << muxChannel);
+  this->clientChannels      &= ~(1 << muxChannel);
+  this->tcpChannels         &= ~(1 << muxChannel);
+  this->pendingSendChannels &= ~(1 << muxChannel);
+  this->failedSendChannels  &= ~(1 << muxChannel);
+  this->pendingSends[muxChannel] = 0;
+  
+#if ESP8266_ENABLE_SERVER
+  this->eventStreamChannels &= ~(1 << muxChannel);
+  this->longPollChannels    &= ~(1 << muxChannel);
+  this->serverChannels      &= ~(1 << muxChannel);
+  this->pendingChannels     &= ~(1 << muxChannel);
+  this->shedChannels        &= ~(1 << muxChannel);
+#endif
+  
+#if ESP8266_ENABLE_WEBSOCKET
+  this->webSocketChannels   &= ~(1 << muxChannel);
+  if(this->webSocketFrameChannel == muxChannel) this->webSocketFrameChannel = -1;
+#endif
+}
+
+byte ESP8266_Simple::setTimeout(int seconds)
+{
+  this->generalCommandTimeoutMicroseconds = seconds * 1000000UL;
+  this->commandTimeoutMicroseconds[ESP8266_COMMAND_QUICK] = this->generalCommandTimeoutMicroseconds;
+  
+  return ESP8266_OK;
+}
+
+void ESP8266_Simple::setCommandTimeout(byte commandClass, unsigned long milliseconds)
+{
+  if(commandClass >= ESP8266_COMMAND_CLASSES) return;
+  this->commandTimeoutMicroseconds[commandClass] = milliseconds * 1000;
+}
+
+#if ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+void ESP8266_Simple::setAdaptiveTimeouts(byte percent)
+{
+  this->adaptiveTimeoutPercent = percent;
+}
+#endif // ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+
+unsigned long ESP8266_Simple::getCommandTimeout(byte commandClass)
+{
+  if(commandClass >= ESP8266_COMMAND_CLASSES) commandClass = ESP8266_COMMAND_QUICK;
+  
+  unsigned long ceiling = this->commandTimeoutMicroseconds[commandClass];
+#if ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+  if(!this->adaptiveTimeoutPercent || this->latencySamples[commandClass] < ESP8266_ADAPTIVE_MIN_SAMPLES) return ceiling;
+  
+  unsigned long adaptive = (this->latencyAverage[commandClass] + 4 * this->latencyDeviation[commandClass]) / 100 * this->adaptiveTimeoutPercent;
+  return constrain(adaptive, ESP8266_ADAPTIVE_MIN_MICROSECONDS, ceiling);
+#else
+  return ceiling;
+#endif
+}
+
+// Which timeout applies to a command, anything not starting with AT is data
+byte ESP8266_Simple::commandClassOf(const char *cmd)
+{
+  if(strncmp_P(cmd, PSTR("AT+C"), 4) != 0)
+  {
+    return strncmp_P(cmd, PSTR("AT"), 2) == 0 ? ESP8266_COMMAND_QUICK : ESP8266_COMMAND_SEND;
+  }
+  
+  if(strncmp_P(cmd+4, PSTR("WJAP="),    5) == 0) return ESP8266_COMMAND_JOIN;
+  if(strncmp_P(cmd+4, PSTR("WLAP"),     4) == 0) return ESP8266_COMMAND_JOIN;
+  if(strncmp_P(cmd+4, PSTR("IPSTART"),  7) == 0) return ESP8266_COMMAND_CONNECT;
+  if(strncmp_P(cmd+4, PSTR("IPSEND"),   6) == 0) return ESP8266_COMMAND_SEND;
+  if(strncmp_P(cmd+4, PSTR("IPCLOSE"),  7) == 0) return ESP8266_COMMAND_SEND;
+  
+  return ESP8266_COMMAND_QUICK;
+}
+
+#if ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+// Smoothed mean and mean deviation (1/8 and 1/4 gains, as TCP's RTO)
+void ESP8266_Simple::noteLatency(byte commandClass, unsigned long microseconds, byte responseCode)
+{
+  if(responseCode == ESP8266_TIMEOUT)
+  {
+    // Either it's slower than we thought, or it's not answering, either way
+    // give it more time next time
+    if(this->latencySamples[commandClass]) 
+    {
+      this->latencyDeviation[commandClass] = min(this->latencyDeviation[commandClass] * 2 + ESP8266_ADAPTIVE_MIN_MICROSECONDS, this->commandTimeoutMicroseconds[commandClass]);
+    }
+    return;
+  }
+  
+  // Only a real answer tells us how long it takes to answer
+  if(responseCode != ESP8266_OK && responseCode != ESP8266_ERROR) return;
+  
+  if(!this->latencySamples[commandClass])
+  {
+    this->latencyAverage[commandClass]   = microseconds;
+    this->latencyDeviation[commandClass] = microseconds / 2;
+  }
+  else
+  {
+    long error = (long) microseconds - (long) this->latencyAverage[commandClass];
+    this->latencyAverage[commandClass]  += error / 8;
+    this->latencyDeviation[commandClass] = this->latencyDeviation[commandClass] - this->latencyDeviation[commandClass] / 4 + labs(error) / 4;
+  }
+  
+  if(this->latencySamples[commandClass] < 255) this->latencySamples[commandClass]++;
+}
+#endif // ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+
+long ESP8266_Simple::connectToWifi(const char *SSID, const char *Password)
+{
+  byte returnValue;
+  
+  // First set to client mode
+  returnValue = this->setWifiMode(ESP8266_STATION);
+  if(returnValue != ESP8266_OK) return returnValue;
+  
+  // Not sure if a QAP is a good idea here?
+  /*
+    returnValue = this->disconnectFromWifi();
+    if(returnValue != ESP8266_OK) return returnValue;
+  */
+  
+  
+  char atCmd[11];
+  strcpy_P(atCmd, PSTR("AT+CWJAP=\"")); // PSTR monkeying to save a few bytes
+  const char *cmdParts[] = {
+    atCmd,
+    SSID,
+    "\",\"",
+    Password,
+    "\""
+  };
+  
+  this->invalidateStationCache();
+  
+  // Connecting to Wifi takes a while, but that's what ESP8266_COMMAND_JOIN is for
+  return this->sendCommand((const char **)cmdParts,(byte)5, (char *)NULL,(int)0, (byte)1);
+}
+
+byte ESP8266_Simple::disconnectFromWifi()
+{
+  this->invalidateStationCache();
+  return this->sendCommand(F("AT+CWQAP"));  
+}
+
+#if ESP8266_ENABLE_SERVER
+byte ESP8266_Simple::startHttpServer(unsigned port, ESP8266_HttpServerHandler *httpServerHandlersArg, unsigned int numOfHandlers, unsigned int maxBufferSize, Print *debugPrinter) 
 {
   byte responseCode;
   
+  // Unless told otherwise, keep trying forever
+  ESP8266_RetryPolicy  defaultRetryPolicy(0, 0, 0);
+  ESP8266_RetryPolicy *retryPolicy = this->retryPolicy ? this->retryPolicy : &defaultRetryPolicy;
+  
   this->httpServerHandlers = httpServerHandlersArg;
   this->httpServerHandlersLength = numOfHandlers;
-    
+  
+  ESP8266_RetryAttempt startAttempt;
   do
   {
     if(debugPrinter)
@@ -379,7 +1087,14 @@ byte ESP8266_Simple::startHttpServer(unsigned port, ESP8266_HttpServerHandler *h
         debugPrinter->print(F("Starting HTTP Server: "));
     }
     
-    if((responseCode = this->startHttpServer(port, (long unsigned int (*)(char*, int))NULL, maxBufferSize) != ESP8266_OK))
+    if(retryPolicy->isOpen())
+    {
+      responseCode = ESP8266_CIRCUIT_OPEN;
+      this->debugPrintError(responseCode, debugPrinter);
+      break;
+    }
+    
+    if((responseCode = this->startHttpServer(port, (long unsigned int (*)(char*, int))NULL, maxBufferSize)) != ESP8266_OK)
     {
       if(debugPrinter)
       {
@@ -392,13 +1107,12 @@ byte ESP8266_Simple::startHttpServer(unsigned port, ESP8266_HttpServerHandler *h
       {
         debugPrinter->println(F("OK"));
       }
-      break;
+      retryPolicy->succeeded(startAttempt);
     }
   }
-  while(1);
-  
+  while(responseCode != ESP8266_OK && retryPolicy->retry(startAttempt, responseCode));
   
-  return ESP8266_OK;
+  return responseCode;
 }
 
 
@@ -414,11 +1128,21 @@ byte ESP8266_Simple::startHttpServer(unsigned port, unsigned long (* requestHand
   responseCode = this->sendCommand(F("AT+CIPMUX=1"));
   if(responseCode != ESP8266_OK) return responseCode;
   
-  // Set Server Timeout
-  memset(cmdBuffer,0,sizeof(cmdBuffer));
-  strcpy_P(cmdBuffer, PSTR("AT+CIPSTO=,"));
-  ultoa(this->generalCommandTimeoutMicroseconds/1000/1000, cmdBuffer+strlen(cmdBuffer), 10);    
-  this->sendCommand(cmdBuffer);
+  // Where the firmware can, let it refuse connections beyond the one we need 
+  // to say 503 on, it has to be done before the server is started
+  if(this->maxServerConnections && this->hasFeature(ESP8266_FEATURE_SERVERMAXCONN))
+  {
+    memset(cmdBuffer,0,sizeof(cmdBuffer));
+    strcpy_P(cmdBuffer, PSTR("AT+CIPSERVERMAXCONN="));
+    itoa(min(this->maxServerConnections + 1, ESP8266_MUX_CHANNELS), cmdBuffer+strlen(cmdBuffer), 10);
+    this->sendCommand(cmdBuffer);
+  }
+  
+  // For rate limiting we need to know who is asking
+  if(this->rateLimitMaxRequests && this->hasFeature(ESP8266_FEATURE_IPDINFO))
+  {
+    this->sendCommand(F("AT+CIPDINFO=1"));
+  }
   
   // Start Server
   memset(cmdBuffer,0,sizeof(cmdBuffer));
@@ -426,7 +1150,15 @@ byte ESP8266_Simple::startHttpServer(unsigned port, unsigned long (* requestHand
   itoa(port, cmdBuffer+strlen(cmdBuffer), 10);    
   responseCode = this->sendCommand(cmdBuffer);
   if(responseCode != ESP8266_OK) return responseCode;
-    
+  
+  // Set Server Timeout (this used to be sent as "AT+CIPSTO=,2", which the 
+  // ESP8266 refused, so it was always the default 180 seconds)
+  memset(cmdBuffer,0,sizeof(cmdBuffer));
+  strcpy_P(cmdBuffer, PSTR("AT+CIPSTO="));
+  ultoa(this->serverIdleSeconds, cmdBuffer+strlen(cmdBuffer), 10);    
+  this->sendCommand(cmdBuffer);
+  
+  this->httpServerPort = port;
   return ESP8266_OK;
 }
 
@@ -435,17 +1167,119 @@ byte ESP8266_Simple::stopHttpServer()
   return ESP8266_ERROR;
 }
 
+void ESP8266_Simple::setServerLimits(byte maxConnections, unsigned long requestMillis, unsigned int idleSeconds)
+{
+  this->maxServerConnections  = maxConnections;
+  this->requestDeadlineMillis = requestMillis;
+  this->serverIdleSeconds     = idleSeconds;
+}
+
+void ESP8266_Simple::setRateLimit(byte maxRequests, unsigned int windowSeconds)
+{
+  this->rateLimitMaxRequests   = maxRequests;
+  this->rateLimitWindowSeconds = windowSeconds;
+  memset(this->rateLimitClients, 0, sizeof(this->rateLimitClients));
+}
+
+void ESP8266_Simple::getServerStats(ESP8266_ServerStats &serverStats)
+{
+  memcpy(&serverStats, &this->serverStats, sizeof(serverStats));
+}
+
+// Give the 503 to connections over the limit, and close those which haven't 
+// sent a request in time, only done when there is nothing waiting to be read
+// (a command now would throw it away)
+void ESP8266_Simple::enforceServerLimits()
+{
+  for(int muxChannel = 0; muxChannel < ESP8266_MUX_CHANNELS; muxChannel++)
+  {
+    if(this->shedChannels & (1 << muxChannel))
+    {
+      this->serverStats.shedConnections++;
+      this->shedConnection(muxChannel);
+    }
+    else if(this->requestDeadlineMillis && (this->pendingChannels & (1 << muxChannel)) && millis() - this->channelOpenedMillis[muxChannel] >= this->requestDeadlineMillis)
+    {
+      this->serverStats.slowConnections++;
+      this->closeConnection(muxChannel);
+      this->channelClosed(muxChannel);
+    }
+    
+    if(this->espSerial->available()) return;
+  }
+}
+
+byte ESP8266_Simple::shedConnection(int muxChannel)
+{
+  char response[sizeof(httpServiceUnavailable)];
+  byte responseCode;
+  
+  strcpy_P(response, httpServiceUnavailable);
+  responseCode = this->sendData(muxChannel, response, strlen(response));
+  this->closeConnection(muxChannel);
+  this->channelClosed(muxChannel);
+  
+  return responseCode;
+}
+
+// Count a request from this client, 1 if it has had too many, when there are
+// too many clients to remember, the one whose window started longest ago is forgotten
+byte ESP8266_Simple::isRateLimited(unsigned long ip)
+{
+  ESP8266_RateLimitClient *client = NULL;
+  byte i;
+  
+  if(!this->rateLimitMaxRequests || !ip) return 0;
+  
+  for(i = 0; i < ESP8266_RATE_LIMIT_CLIENTS; i++)
+  {
+    if(this->rateLimitClients[i].ip == ip)
+    {
+      client = &this->rateLimitClients[i];
+      break;
+    }
+    
+    if(!client || !this->rateLimitClients[i].ip || millis() - this->rateLimitClients[i].windowStartMillis > millis() - client->windowStartMillis)
+    {
+      client = &this->rateLimitClients[i];
+    }
+  }
+  
+  if(client->ip != ip || millis() - client->windowStartMillis >= this->rateLimitWindowSeconds * 1000UL)
+  {
+    client->ip                = ip;
+    client->windowStartMillis = millis();
+    client->requests          = 0;
+  }
+  
+  if(client->requests >= this->rateLimitMaxRequests) return 1;
+  
+  client->requests++;
+  return 0;
+}
+
 byte ESP8266_Simple::serveHttpRequest()
 {
-  if(!this->espSerial->available()) return ESP8266_OK; // Nothing to do
+  this->listen();
+  if(!this->espSerial->available()) 
+  {
+    // Nothing to do, except perhaps turn away some clients
+    if(this->serverChannels) this->enforceServerLimits();
+    return ESP8266_OK;
+  }
 
   char cmdBuffer[64];
-  char hdrBuffer[64];     
+  
+  // The longest is "HTTP/1.0 nnn\r\nContent-type: application/cbor\r\nContent-Length: nnnnn\r\n\r\n"
+  char hdrBuffer[96];
   
   char dataBuffer[this->httpServerMaxBufferSize];
   int  requestLength;
   byte responseCode;
   unsigned long  httpStatusCodeAndType;
+  unsigned int   bodyLength;
+  ESP8266_SlowRequest profile;
+  unsigned long       profileMicros;
   int  muxChannel = -1; // This will be set by readIPD(), we need to start with -1
                         // to indicate we will accept any channel, we will get
                         // packet data for whatever channel is first off the block
@@ -454,10 +1288,77 @@ byte ESP8266_Simple::serveHttpRequest()
   
   memset(dataBuffer,0,sizeof(dataBuffer));
   
-  if((requestLength = this->readIPD(dataBuffer,sizeof(dataBuffer),-1,NULL,&muxChannel)))
+#if ESP8266_ENABLE_WEBSOCKET
+  // If we might accept a WebSocket, readIPD() needs to keep an eye out for the key
+  char webSocketKey[25];
+  webSocketKey[0] = 0;
+  this->webSocketKey = this->webSocketHandler ? webSocketKey : NULL;
+#endif
+  
+  char ifNoneMatch[ESP8266_ETAG_SIZE];
+  ifNoneMatch[0] = 0;
+  this->ifNoneMatch = this->httpAssets ? ifNoneMatch : NULL;
+  
+  memset(&profile, 0, sizeof(profile));
+  profile.startMillis = millis();
+  profileMicros       = micros();
+  
+  this->acceptsCbor      = 0;
+  this->capturingRequest = 1;
+  requestLength = this->readIPD(dataBuffer,sizeof(dataBuffer),-1,NULL,&muxChannel);
+#if ESP8266_ENABLE_WEBSOCKET
+  this->webSocketKey     = NULL;
+#endif
+  this->ifNoneMatch      = NULL;
+  this->capturingRequest = 0;
+  
+  profile.receiveMicros = micros() - profileMicros;
+  
+  if(requestLength && muxChannel >= 0)
+  {
+    this->pendingChannels &= ~(1 << muxChannel);
+    
+    // Over the limit (and it asked before we had time to say so), or asking too often
+    if(this->shedChannels & (1 << muxChannel))
+    {
+      this->serverStats.shedConnections++;
+      return this->shedConnection(muxChannel);
+    }
+    if(this->isRateLimited(this->remoteIp))
+    {
+      this->serverStats.rateLimitedRequests++;
+      return this->shedConnection(muxChannel);
+    }
+  }
+  
+  if(requestLength)
   {
+    if(this->serverStatusRoute && strncmp_P(dataBuffer, this->serverStatusRoute, strlen_P(this->serverStatusRoute)) == 0)
+    {
+      return this->serveServerStatus(muxChannel);
+    }
+    
+    for(byte x = 0; x < this->numHttpAssets; x++)
+    {
+      ESP8266_HttpAsset asset;
+      memcpy_P(&asset, &this->httpAssets[x], sizeof(asset));
+      
+      if(strncmp_P(dataBuffer, asset.requestMatches, strlen_P(asset.requestMatches)) == 0)
+      {
+        // It's read, we can use the buffer for sending now
+        dataBuffer[sizeof(dataBuffer)-1] = 0;
+        this->ifNoneMatch = ifNoneMatch;
+        responseCode = this->serveHttpAsset(muxChannel, asset, dataBuffer, sizeof(dataBuffer));
+        this->ifNoneMatch = NULL;
+        return responseCode;
+      }
+    }
+    
     // Call the handler, note we reserve the last byte of the data buffer
     // it will always be null for safety
+    this->dispatchedRoute  = -1;
+    this->dispatchedMicros = 0;
+    profileMicros = micros();
     if(this->httpServerRequestHandler)
     {
       httpStatusCodeAndType = (*(this->httpServerRequestHandler))(dataBuffer,sizeof(dataBuffer)-1);
@@ -466,6 +1367,22 @@ byte ESP8266_Simple::serveHttpRequest()
     {      
       httpStatusCodeAndType = this->httpServerRequestHandler_Builtin(dataBuffer, sizeof(dataBuffer)-1);
     }
+    // A binary body says how long it is, take that out so that 
+    // only the status code is left
+    if(httpStatusCodeAndType & ESP8266_CBOR)
+    {
+      bodyLength = min((httpStatusCodeAndType >> 10) & 0x3FFF, sizeof(dataBuffer)-1);
+      httpStatusCodeAndType &= ~0x00FFFC00UL;
+    }
+    else
+    {
+      bodyLength = min(sizeof(dataBuffer)-1, strlen(dataBuffer));
+    }
+    
+    profile.route          = this->dispatchedRoute;
+    profile.dispatchMicros = this->dispatchedMicros;
+    profile.handlerMicros  = micros() - profileMicros - this->dispatchedMicros;
+    profile.httpStatus     = httpStatusCodeAndType & 0x00FFFFFF;
     
     // Ensure that the last byte of the buffer is null for safety
     dataBuffer[sizeof(dataBuffer)-1] = 0;
@@ -474,6 +1391,28 @@ byte ESP8266_Simple::serveHttpRequest()
     memset(hdrBuffer, 0, sizeof(hdrBuffer));
     memset(cmdBuffer,0,sizeof(cmdBuffer));
     
+    if(httpStatusCodeAndType & ESP8266_WEBSOCKET)
+    {
+#if ESP8266_ENABLE_WEBSOCKET
+      if(webSocketKey[0])
+      {
+        return this->acceptWebSocket(muxChannel, webSocketKey);
+      }
+#endif
+      
+      // Not a (complete) WebSocket request
+      memset(dataBuffer, 0, sizeof(dataBuffer));
+      httpStatusCodeAndType = ESP8266_TEXT | 400;
+      bodyLength            = 0;
+    }
+    
+    // Hang on to it until there is something to say
+    if(httpStatusCodeAndType & ESP8266_LONGPOLL)
+    {
+      this->longPollChannels |= (1 << muxChannel);
+      return ESP8266_OK;
+    }
+    
     // If it's not a raw response, make some headers
     if(!(httpStatusCodeAndType & ESP8266_RAW))
     {
@@ -491,30 +1430,67 @@ byte ESP8266_Simple::serveHttpRequest()
           strncpy_P(hdrBuffer+strlen(hdrBuffer), PSTR("text/plain"), sizeof(hdrBuffer)-strlen(hdrBuffer)-1);
           break;          
 
+        case ESP8266_EVENTSTREAM:
+          strncpy_P(hdrBuffer+strlen(hdrBuffer), PSTR("text/event-stream"), sizeof(hdrBuffer)-strlen(hdrBuffer)-1);
+          break;          
+
+        case ESP8266_CBOR:
+          strncpy_P(hdrBuffer+strlen(hdrBuffer), PSTR("application/cbor"), sizeof(hdrBuffer)-strlen(hdrBuffer)-1);
+          break;          
+      }
+      
+      // An event stream has no end, so no length
+      if(!(httpStatusCodeAndType & ESP8266_EVENTSTREAM))
+      {
+        strncpy_P(hdrBuffer + strlen(hdrBuffer), PSTR("\r\nContent-Length: "), sizeof(hdrBuffer) - strlen(hdrBuffer) - 1);
+        itoa(bodyLength, hdrBuffer + strlen(hdrBuffer), 10);
       }
-      strncpy_P(hdrBuffer + strlen(hdrBuffer), PSTR("\r\nContent-Length: "), sizeof(hdrBuffer) - strlen(hdrBuffer) - 1);
-      itoa(strlen(dataBuffer), hdrBuffer + strlen(hdrBuffer), 10);
       strncpy_P(hdrBuffer+strlen(hdrBuffer), PSTR("\r\n\r\n"), sizeof(hdrBuffer)-strlen(hdrBuffer)-1);
     }
     
-    // Create the send command which specifies the mux channel and data length    
-    strncpy_P(cmdBuffer,PSTR("AT+CIPSEND="),sizeof(cmdBuffer));
-    itoa(muxChannel,cmdBuffer+strlen(cmdBuffer),10); // With Mux
-    cmdBuffer[strlen(cmdBuffer)]=',';
-    itoa(strlen(hdrBuffer)+min(sizeof(dataBuffer)-1,strlen(dataBuffer)), cmdBuffer+strlen(cmdBuffer),10);
+    profile.responseBytes = strlen(hdrBuffer)+bodyLength;
+    profileMicros = micros();
     
-    if((responseCode = this->sendCommand(cmdBuffer)) != ESP8266_OK) 
+    if(this->canPipeline(muxChannel))
     {
-      return responseCode;
+      // Queued with AT+CIPSENDBUF, closeConnection() waits for it to go
+      if((responseCode = this->sendData(muxChannel, hdrBuffer, dataBuffer, bodyLength)) != ESP8266_OK)
+      {
+        return responseCode;
+      }
+    }
+    else
+    {
+      // Create the send command which specifies the mux channel and data length    
+      strncpy_P(cmdBuffer,PSTR("AT+CIPSEND="),sizeof(cmdBuffer));
+      itoa(muxChannel,cmdBuffer+strlen(cmdBuffer),10); // With Mux
+      cmdBuffer[strlen(cmdBuffer)]=',';
+      itoa(profile.responseBytes, cmdBuffer+strlen(cmdBuffer),10);
+      
+      if((responseCode = this->sendCommand(cmdBuffer)) != ESP8266_OK) 
+      {
+        return responseCode;
+      }
+      
+      this->espSerial->print(hdrBuffer);
+      this->espSerial->write((const uint8_t *) dataBuffer, bodyLength);
     }
+    profile.sendMicros = micros() - profileMicros;
     
-    this->espSerial->print(hdrBuffer);
-    this->espSerial->print(dataBuffer);
+    // Leave it open for pushEvent()
+    if(httpStatusCodeAndType & ESP8266_EVENTSTREAM)
+    {
+      this->eventStreamChannels |= (1 << muxChannel);
+      this->noteServerProfile(profile);
+      return ESP8266_OK;
+    }
         
-    memset(cmdBuffer,0,sizeof(cmdBuffer));
-    strncpy_P(cmdBuffer, PSTR("AT+CIPCLOSE="), sizeof(cmdBuffer)-1);
-    itoa(muxChannel, cmdBuffer+strlen(cmdBuffer),10);
-    if((responseCode = this->sendCommand(cmdBuffer)) != ESP8266_OK)
+    profileMicros = micros();
+    responseCode = this->closeConnection(muxChannel);
+    this->channelClosed(muxChannel);
+    profile.closeMicros = micros() - profileMicros;
+    this->noteServerProfile(profile);
+    if(responseCode != ESP8266_OK)
     {
       return responseCode;
     } 
@@ -528,27 +1504,505 @@ byte ESP8266_Simple::serveHttpRequest()
 }
 
 
+void ESP8266_Simple::profileServer(ESP8266_RouteStats *routeStats, byte numRoutes, ESP8266_SlowRequest *slowRequests, byte numSlowRequests, unsigned long slowMillis)
+{
+  this->routeStats        = routeStats;
+  this->numRoutes         = routeStats ? numRoutes : 0;
+  this->slowRequests      = slowRequests;
+  this->numSlowRequests   = slowRequests ? numSlowRequests : 0;
+  this->nextSlowRequest   = 0;
+  this->slowRequestMicros = slowMillis * 1000;
+  
+  if(this->routeStats)   memset(this->routeStats,   0, this->numRoutes * sizeof(ESP8266_RouteStats));
+  if(this->slowRequests) memset(this->slowRequests, 0, this->numSlowRequests * sizeof(ESP8266_SlowRequest));
+}
+
+byte ESP8266_Simple::getSlowRequest(byte n, ESP8266_SlowRequest &slowRequest)
+{
+  if(n >= this->numSlowRequests) return 0;
+  
+  // The ring fills from nextSlowRequest backwards in time
+  memcpy(&slowRequest, &this->slowRequests[(this->nextSlowRequest + this->numSlowRequests - 1 - n) % this->numSlowRequests], sizeof(slowRequest));
+  return slowRequest.totalMicros ? 1 : 0;
+}
+
+void ESP8266_Simple::setServerStatusRoute(const char *statusRequest)
+{
+  this->serverStatusRoute = statusRequest;
+}
+
+void ESP8266_Simple::noteServerProfile(ESP8266_SlowRequest &profile)
+{
+  profile.totalMicros = profile.receiveMicros + profile.dispatchMicros + profile.handlerMicros + profile.sendMicros + profile.closeMicros;
+  
+  if(profile.route >= 0 && profile.route < this->numRoutes)
+  {
+    ESP8266_RouteStats *route = &this->routeStats[profile.route];
+    
+    route->requests++;
+    route->receiveMicros  += profile.receiveMicros;
+    route->dispatchMicros += profile.dispatchMicros;
+    route->handlerMicros  += profile.handlerMicros;
+    route->sendMicros     += profile.sendMicros;
+    route->closeMicros    += profile.closeMicros;
+    route->responseBytes  += profile.responseBytes;
+    route->maxMicros       = max(route->maxMicros, profile.totalMicros);
+  }
+  
+  if(this->numSlowRequests && profile.totalMicros >= this->slowRequestMicros)
+  {
+    memcpy(&this->slowRequests[this->nextSlowRequest], &profile, sizeof(profile));
+    this->nextSlowRequest = (this->nextSlowRequest + 1) % this->numSlowRequests;
+  }
+}
+
+// The profile as text/plain, one line per route (mean microseconds for each
+// part of the request) and then the slow requests, newest first
+byte ESP8266_Simple::serveServerStatus(int muxChannel)
+{
+  char segment[ESP8266_SEND_SEGMENT_SIZE];
+  ESP8266_SendBuffer  status(this, muxChannel, segment, sizeof(segment));
+  ESP8266_SlowRequest slowRequest;
+  byte responseCode;
+  
+  status.print(F("HTTP/1.0 200\r\nContent-type: text/plain\r\n\r\n"));
+  status.println(F("route requests receive dispatch handler send close max bytes"));
+  for(byte x = 0; x < this->numRoutes; x++)
+  {
+    ESP8266_RouteStats *route = &this->routeStats[x];
+    unsigned int requests     = max(route->requests, 1);
+    
+    status.print(x);                                    status.print(' ');
+    status.print(route->requests);                      status.print(' ');
+    status.print(route->receiveMicros  / requests);     status.print(' ');
+    status.print(route->dispatchMicros / requests);     status.print(' ');
+    status.print(route->handlerMicros  / requests);     status.print(' ');
+    status.print(route->sendMicros     / requests);     status.print(' ');
+    status.print(route->closeMicros    / requests);     status.print(' ');
+    status.print(route->maxMicros);                     status.print(' ');
+    status.println(route->responseBytes / requests);
+  }
+  
+  status.println();
+  status.println(F("slow: ago_ms route status receive dispatch handler send close total bytes"));
+  for(byte n = 0; this->getSlowRequest(n, slowRequest); n++)
+  {
+    status.print(millis() - slowRequest.startMillis);  status.print(' ');
+    status.print(slowRequest.route);                    status.print(' ');
+    status.print(slowRequest.httpStatus);               status.print(' ');
+    status.print(slowRequest.receiveMicros);            status.print(' ');
+    status.print(slowRequest.dispatchMicros);           status.print(' ');
+    status.print(slowRequest.handlerMicros);            status.print(' ');
+    status.print(slowRequest.sendMicros);               status.print(' ');
+    status.print(slowRequest.closeMicros);              status.print(' ');
+    status.print(slowRequest.totalMicros);              status.print(' ');
+    status.println(slowRequest.responseBytes);
+  }
+  
+  responseCode = status.send();
+  if(responseCode == ESP8266_OK) responseCode = this->flushSends(muxChannel);
+  this->closeConnection(muxChannel);
+  this->channelClosed(muxChannel);
+  return responseCode;
+}
+
+byte ESP8266_Simple::pushEvent(const char *data, const char *eventName)
+{
+  char segment[ESP8266_SEND_SEGMENT_SIZE];
+  byte sentTo = 0;
+  const char *line;
+  
+  this->listen();
+  
+  for(int muxChannel = 0; muxChannel < ESP8266_MUX_CHANNELS; muxChannel++)
+  {
+    if(this->eventStreamChannels & (1 << muxChannel))
+    {
+      // Each event is one segment (one AT+CIPSEND) unless it's too big to fit
+      ESP8266_SendBuffer event(this, muxChannel, segment, sizeof(segment));
+      
+      if(!data)
+      {
+        event.print(F(":\n\n"));
+      }
+      else
+      {
+        if(eventName)
+        {
+          event.print(F("event: "));
+          event.print(eventName);
+          event.print('\n');
+        }
+        
+        // Each line of the data needs it's own "data:" field
+        event.print(F("data: "));
+        for(line = data; *line; line++)
+        {
+          event.print(*line);
+          if(*line == '\n' && *(line+1)) event.print(F("data: "));
+        }
+        if(line > data && *(line-1) != '\n') event.print('\n');
+        event.print('\n');
+      }
+      
+      if(event.send() == ESP8266_OK)
+      {
+        sentTo++;
+      }
+      else
+      {
+        this->closeConnection(muxChannel);
+        this->channelClosed(muxChannel);
+      }
+    }
+    else if(data && (this->longPollChannels & (1 << muxChannel)))
+    {
+      ESP8266_SendBuffer response(this, muxChannel, segment, sizeof(segment));
+      
+      response.print(F("HTTP/1.0 200\r\nContent-type: text/plain\r\nContent-Length: "));
+      response.print(strlen(data));
+      response.print(F("\r\n\r\n"));
+      response.print(data);
+      
+      // Queued (AT+CIPSENDBUF) isn't sent, it only counts once it has gone
+      if(response.send() == ESP8266_OK && this->flushSends(muxChannel) == ESP8266_OK) sentTo++;
+      
+      this->closeConnection(muxChannel);
+      this->channelClosed(muxChannel);
+    }
+  }
+  
+  return sentTo;
+}
+
+byte ESP8266_Simple::getEventSubscriberCount()
+{
+  byte count = 0;
+  
+  for(byte channels = this->eventStreamChannels | this->longPollChannels; channels; channels >>= 1)
+  {
+    if(channels & 1) count++;
+  }
+  
+  return count;
+}
+
+#if ESP8266_ENABLE_WEBSOCKET
+void ESP8266_Simple::setWebSocketHandler(ESP8266_WebSocketHandler webSocketHandler)
+{
+  this->webSocketHandler = webSocketHandler;
+}
+
+// If this header line is the Sec-WebSocket-Key, keep it (it's always 24 characters)
+void ESP8266_Simple::captureWebSocketKey(const char *line)
+{
+  if(strncasecmp_P(line, PSTR("Sec-WebSocket-Key:"), 18) != 0) return;
+  
+  for(line += 18; *line == ' '; line++);
+  
+  if(strlen(line) < 24 || (line[24] != '\r' && line[24] != '\n')) return; // Truncated
+  
+  memcpy(this->webSocketKey, line, 24);
+  this->webSocketKey[24] = 0;
+}
+#endif // ESP8266_ENABLE_WEBSOCKET
+
+// Note the request headers we care about, an Accept which includes 
+// application/cbor, and If-None-Match (when wanted)
+void ESP8266_Simple::captureRequestHeader(const char *line)
+{
+  if(strncasecmp_P(line, PSTR("Accept:"), 7) == 0)
+  {
+    if(strstr_P(line, PSTR("application/cbor")))
+    {
+      this->acceptsCbor = 1;
+    }
+    return;
+  }
+  
+  if(this->ifNoneMatch && strncasecmp_P(line, PSTR("If-None-Match:"), 14) == 0)
+  {
+    byte length;
+    
+    for(line += 14; *line == ' '; line++);
+    for(length = 0; line[length] && line[length] != '\r' && line[length] != '\n'; length++);
+    
+    if(length >= ESP8266_ETAG_SIZE) return; // A list, or not one of ours
+    
+    memcpy(this->ifNoneMatch, line, length);
+    this->ifNoneMatch[length] = 0;
+  }
+}
+
+void ESP8266_Simple::setHttpAssets(const ESP8266_HttpAsset *assets, byte numAssets)
+{
+  this->httpAssets    = assets;
+  this->numHttpAssets = assets ? numAssets : 0;
+}
+
+// The headers and body are sent as they are from flash, a buffer at a time
+byte ESP8266_Simple::serveHttpAsset(int muxChannel, const ESP8266_HttpAsset &asset, char *buffer, int bufferLength)
+{
+  ESP8266_SendBuffer response(this, muxChannel, buffer, bufferLength);
+  byte responseCode;
+  
+  if(this->ifNoneMatch && this->ifNoneMatch[0] && strcmp_P(this->ifNoneMatch, asset.etag) == 0)
+  {
+    response.print(F("HTTP/1.0 304 Not Modified\r\nETag: "));
+    response.print((const __FlashStringHelper *) asset.etag);
+    response.print(F("\r\n\r\n"));
+  }
+  else
+  {
+    response.print((const __FlashStringHelper *) asset.headers);
+    for(unsigned int x = 0; x < asset.bodyLength; x++)
+    {
+      response.write(pgm_read_byte(asset.body + x));
+    }
+  }
+  
+  responseCode = response.send();
+  if(responseCode == ESP8266_OK) responseCode = this->flushSends(muxChannel);
+  this->closeConnection(muxChannel);
+  this->channelClosed(muxChannel);
+  return responseCode;
+}
+
+byte ESP8266_Simple::requestAcceptsCbor()
+{
+  return this->acceptsCbor;
+}
+
+#if ESP8266_ENABLE_WEBSOCKET
+byte ESP8266_Simple::acceptWebSocket(int muxChannel, const char *webSocketKey)
+{
+  static const char base64[] PROGMEM = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  char segment[ESP8266_SEND_SEGMENT_SIZE];
+  byte hash[21];
+  byte i;
+  byte responseCode;
+  
+  ESP8266_Sha1 sha1;
+  sha1.print(webSocketKey);
+  sha1.print(F("258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+  sha1.result(hash);
+  hash[20] = 0;
+  
+  ESP8266_SendBuffer response(this, muxChannel, segment, sizeof(segment));
+  response.print(F("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: "));
+  
+  // Base64 of the 20 byte hash is 28 characters, the last one padding
+  for(i = 0; i < 21; i += 3)
+  {
+    response.print((char) pgm_read_byte(&base64[hash[i] >> 2]));
+    response.print((char) pgm_read_byte(&base64[((hash[i] & 0x03) << 4) | (hash[i+1] >> 4)]));
+    if(i == 18)
+    {
+      response.print((char) pgm_read_byte(&base64[(hash[i+1] & 0x0F) << 2]));
+      response.print('=');
+    }
+    else
+    {
+      response.print((char) pgm_read_byte(&base64[((hash[i+1] & 0x0F) << 2) | (hash[i+2] >> 6)]));
+      response.print((char) pgm_read_byte(&base64[hash[i+2] & 0x3F]));
+    }
+  }
+  response.print(F("\r\n\r\n"));
+  
+  if((responseCode = response.send()) != ESP8266_OK) return responseCode;
+  
+  this->webSocketChannels |= (1 << muxChannel);
+  return ESP8266_OK;
+}
+
+// Read one +IPD packet's worth of frames (or parts of frames) from a WebSocket
+void ESP8266_Simple::receiveWebSocket(int muxChannel, int packetLength)
+{
+  ESP8266_WebSocketChannel *frame = &this->webSocketFrame;
+  char chunk[ESP8266_WEBSOCKET_CHUNK_SIZE];
+  char pong[ESP8266_WEBSOCKET_CHUNK_SIZE];
+  int  chunkLength = 0;
+  int  pongLength  = -1;
+  int  closeAfter  = -1;
+  int  c;
+  byte opcode;
+  
+  // Somebody else's frame was left half done, there's no recovering that one
+  if(this->webSocketFrameChannel >= 0 && this->webSocketFrameChannel != muxChannel)
+  {
+    closeAfter = this->webSocketFrameChannel;
+  }
+  
+  if(this->webSocketFrameChannel != muxChannel)
+  {
+    memset(frame, 0, sizeof(ESP8266_WebSocketChannel));
+    frame->headerLength = 2;
+    this->webSocketFrameChannel = muxChannel;
+  }
+  
+  this->webSocketUnread = packetLength;
+  while(this->webSocketUnread > 0)
+  {
+    if(!this->espSerial->waitUntilAvailable()) break;
+    c = this->espSerial->read();
+    this->webSocketUnread--;
+    
+    if(frame->headerIndex < frame->headerLength)
+    {
+      if(frame->headerIndex == 0)
+      {
+        frame->opcode = c;
+      }
+      else if(frame->headerIndex == 1)
+      {
+        // Client frames are always masked, and we only do 16 bit lengths
+        frame->payloadLength = c & 0x7F;
+        frame->headerLength  = 2 + 4 + (frame->payloadLength == 126 ? 2 : 0);
+        if(!(c & 0x80) || frame->payloadLength == 127) closeAfter = muxChannel;
+        if(frame->payloadLength == 126) frame->payloadLength = 0;
+      }
+      else if(frame->headerIndex < frame->headerLength - 4)
+      {
+        frame->payloadLength = (frame->payloadLength << 8) | c;
+      }
+      else
+      {
+        frame->mask[frame->headerIndex - (frame->headerLength - 4)] = c;
+      }
+      
+      // An empty frame is complete as soon as the header is
+      if(++frame->headerIndex < frame->headerLength || frame->payloadLength) continue;
+    }
+    else
+    {
+      chunk[chunkLength++] = c ^ frame->mask[frame->payloadIndex++ & 3];
+      if(chunkLength < (int) sizeof(chunk) && frame->payloadIndex < frame->payloadLength) continue;
+    }
+    
+    // A whole frame, or a chunk full of one
+    opcode = frame->opcode & 0x0F;
+    if(opcode == ESP8266_WS_PING)
+    {
+      // We can only echo back a payload which fits in one chunk
+      pongLength = frame->payloadLength <= sizeof(pong) ? chunkLength : 0;
+      memcpy(pong, chunk, pongLength);
+    }
+    else if(opcode == ESP8266_WS_CLOSE)
+    {
+      closeAfter = muxChannel;
+    }
+    else if(opcode != ESP8266_WS_PONG && this->webSocketHandler)
+    {
+      this->webSocketHandler(muxChannel, opcode, chunk, chunkLength, (frame->payloadIndex == frame->payloadLength) && (frame->opcode & 0x80));
+    }
+    chunkLength = 0;
+    
+    // Start the next frame
+    if(frame->payloadIndex == frame->payloadLength)
+    {
+      memset(frame, 0, sizeof(ESP8266_WebSocketChannel));
+      frame->headerLength = 2;
+    }
+  }
+  this->webSocketUnread = 0;
+  
+  // The end of the packet in the middle of a frame, hand over what we have
+  if(chunkLength && this->webSocketHandler && (frame->opcode & 0x0F) < ESP8266_WS_CLOSE)
+  {
+    this->webSocketHandler(muxChannel, frame->opcode & 0x0F, chunk, chunkLength, 0);
+  }
+  
+  if(frame->headerIndex == 0) this->webSocketFrameChannel = -1;
+  
+  // Now the packet is read we can answer
+  if(pongLength >= 0) this->sendWebSocket(muxChannel, pong, pongLength, ESP8266_WS_PONG);
+  
+  if(closeAfter >= 0)
+  {
+    this->closeWebSocket(closeAfter);
+    if(this->webSocketHandler) this->webSocketHandler(closeAfter, ESP8266_WS_CLOSE, NULL, 0, 1);
+  }
+}
+
+byte ESP8266_Simple::sendWebSocket(int muxChannel, const char *data, int length, byte opcode)
+{
+  char segment[ESP8266_SEND_SEGMENT_SIZE];
+  byte responseCode = ESP8266_ERROR;
+  
+  if(this->webSocketUnread) return ESP8266_BUSY;
+  
+  this->listen();
+  
+  for(int channel = 0; channel < ESP8266_MUX_CHANNELS; channel++)
+  {
+    if(!(this->webSocketChannels & (1 << channel))) continue;
+    if(muxChannel >= 0 && channel != muxChannel)    continue;
+    
+    // Server frames are not masked, and we only send 16 bit lengths
+    ESP8266_SendBuffer frame(this, channel, segment, sizeof(segment));
+    frame.write(0x80 | opcode);
+    if(length < 126)
+    {
+      frame.write((uint8_t) length);
+    }
+    else
+    {
+      frame.write(126);
+      frame.write((uint8_t) (length >> 8));
+      frame.write((uint8_t) (length & 0xFF));
+    }
+    frame.write((const uint8_t *) data, length);
+    
+    if((responseCode = frame.send()) != ESP8266_OK)
+    {
+      this->channelClosed(channel);
+    }
+  }
+  
+  return responseCode;
+}
+
+byte ESP8266_Simple::closeWebSocket(int muxChannel)
+{
+  byte responseCode;
+  
+  // Closing first would throw away the close frame if it's still queued
+  this->sendWebSocket(muxChannel, NULL, 0, ESP8266_WS_CLOSE);
+  responseCode = this->closeConnection(muxChannel);
+  this->channelClosed(muxChannel);
+  return responseCode;
+}
+#endif // ESP8266_ENABLE_WEBSOCKET
+
 unsigned long ESP8266_Simple::httpServerRequestHandler_Builtin(char *buffer, int bufferLength)
 {    
+  unsigned long startMicros = micros();
+  
   // Loop through the handlers and do a string comparison on the buffer
   // to see if this is what was requested
   for(byte x = 0;x < this->httpServerHandlersLength; x++)
   {
     if(strncmp_P(buffer,this->httpServerHandlers[x].requestMatches,strlen_P(this->httpServerHandlers[x].requestMatches))==0)
     {
+      this->dispatchedRoute  = x;
+      this->dispatchedMicros = micros() - startMicros;
+      
       // And if it was requested, pass off to the handler function to
       // do whatever it needs to do.
       return (this->httpServerHandlers[x].handlerFunction)(buffer, bufferLength);
     }
   }
   
+  this->dispatchedMicros = micros() - startMicros;
+  
   // If we didn't find a valid command, give a 404 of course!
   memset(buffer, 0, bufferLength);  
   //strcpy_P(buffer, PSTR("<h1>Error, Unknown Command</h1>\r\n<p>Try <a href=\"/millis\">/millis</a>, and <a href=\"/led\">/led</a></p>"));
   return ESP8266_HTML | 404;
 }
+#endif // ESP8266_ENABLE_SERVER
 
-
+#if ESP8266_ENABLE_HTTP_CLIENT
 // serverIpAddress = ip address to connect to
 // port = port to connect to (80)
 // requestPathAndResponseBuffer = the path to GET (eg "/blah"), this buffer will also receive the null-terminated response
@@ -565,21 +2019,12 @@ unsigned long ESP8266_Simple::httpServerRequestHandler_Builtin(char *buffer, int
 //    if you set bodyResponseOnlyFromLine = -1, you will get headers from the line matching the absolute value
 //
 // httpResponseCode = if not null, then if we are sent headers, try and find the response code and set this variable to it
-
 byte ESP8266_Simple::sendHttpRequest( unsigned long serverIpAddress, int port,  char *requestPathAndResponseBuffer, int bufferLength, char *httpHost, int bodyResponseOnlyFromLine, int *httpResponseCode )
 {  
   byte responseCode;
   char cmdBuffer[64];    
-  memset(cmdBuffer,0,sizeof(cmdBuffer));
   
-  // Build up the command string
-  //  AT+CIPSTART="TCP","[IP]",[PORT]
-  strncpy_P(cmdBuffer, PSTR("AT+CIPSTART=\"TCP\",\""), sizeof(cmdBuffer));        // Command itself with opening quote for IP
-  this->ipConvertDatatypeFromTo(serverIpAddress, cmdBuffer+strlen(cmdBuffer));  // the IP address
-  strcpy(cmdBuffer+strlen(cmdBuffer),"\",");                                    // closing quote for IP
-  itoa(port,cmdBuffer+strlen(cmdBuffer), 10);                                   // port  
-  
-  responseCode = this->sendCommand(cmdBuffer);
+  responseCode = this->openConnection(ESP8266_TCP, serverIpAddress, port);
   if(responseCode != ESP8266_OK) return responseCode;
   
   // Create the data command
@@ -648,18 +2093,794 @@ byte ESP8266_Simple::sendHttpRequest( unsigned long serverIpAddress, int port,
   }
   else
   {
-    this->readIPD(requestPathAndResponseBuffer,bufferLength,bodyResponseOnlyFromLine);
+    this->readIPD(requestPathAndResponseBuffer,bufferLength,bodyResponseOnlyFromLine);
+  }
+  
+  if(this->unlinkConnection() != ESP8266_OK)
+  {
+    this->recover(ESP8266_RECOVER_CHANNEL);
+  }
+  this->sendCommand(F("AT+CIPSTATUS"));
+  return ESP8266_OK;    
+}
+
+// As above but the request is described by an ESP8266_HttpRequest, we always
+// send HTTP/1.0 here because there may be a body, and the request is streamed
+// out through an ESP8266_SendBuffer so that the body need not fit in memory.
+
+byte ESP8266_Simple::sendHttpRequest( unsigned long serverIpAddress, int port,  char *requestPathAndResponseBuffer, int bufferLength, char *httpHost, ESP8266_HttpRequest *request, int bodyResponseOnlyFromLine, int *httpResponseCode )
+{
+  if(!request) return this->sendHttpRequest(serverIpAddress, port, requestPathAndResponseBuffer, bufferLength, httpHost, bodyResponseOnlyFromLine, httpResponseCode);
+  
+  byte responseCode;
+  char segmentBuffer[ESP8266_SEND_SEGMENT_SIZE];
+  int  httpResponseCodeBuffer = 0;
+  
+  responseCode = this->openConnection(ESP8266_TCP, serverIpAddress, port);
+  if(responseCode != ESP8266_OK) return responseCode;
+  
+  ESP8266_SendBuffer requestOutput(this, -1, segmentBuffer, sizeof(segmentBuffer));
+  this->writeHttpRequest(&requestOutput, requestPathAndResponseBuffer, httpHost, request);
+  
+  // The last segments may still be queued (AT+CIPSENDBUF), they must all be
+  // out before we can expect a response
+  responseCode = requestOutput.send();
+  if(responseCode == ESP8266_OK) responseCode = this->flushSends(-1);
+  if(responseCode != ESP8266_OK)
+  {
+    this->sendCommand(F("AT+CIPCLOSE"));
+    return responseCode;
+  }
+  
+  this->readIPD(requestPathAndResponseBuffer,bufferLength,bodyResponseOnlyFromLine, &httpResponseCodeBuffer, NULL, request->responseHeaders);
+  if(httpResponseCode)
+  {
+    *httpResponseCode = httpResponseCodeBuffer;
+  }
+  
+  if(this->unlinkConnection() != ESP8266_OK)
+  {
+    this->recover(ESP8266_RECOVER_CHANNEL);
+  }
+  this->sendCommand(F("AT+CIPSTATUS"));
+  return ESP8266_OK;    
+}
+
+// The request line, headers and body of an HTTP/1.0 request, request may be NULL for a plain GET
+void ESP8266_Simple::writeHttpRequest(Print *requestOutput, const char *path, const char *httpHost, ESP8266_HttpRequest *request)
+{
+  long contentLength = request ? request->contentLength : 0;
+  
+  // If we have a body but not the length of it, then we have to count it first,
+  // the request is left as it is so that it counts again next time it is used
+  if(request && request->bodyWriter && contentLength < 0)
+  {
+    ESP8266_CountingPrint bodyCounter;
+    (request->bodyWriter)(&bodyCounter, request->bodyWriterContext);
+    contentLength = bodyCounter.count;
+  }
+  
+  requestOutput->print(request && request->method ? (const __FlashStringHelper *)request->method : F("GET"));
+  requestOutput->print(' ');
+  requestOutput->print(path);
+  requestOutput->print(F(" HTTP/1.0\r\n"));
+  if(httpHost)
+  {
+    requestOutput->print(F("Host: "));
+    requestOutput->print(httpHost);
+    requestOutput->print(F("\r\n"));
+  }
+  
+  if(request && request->extraHeaders)
+  {
+    requestOutput->print(request->extraHeaders);
+  }
+  
+  if(request && request->bodyWriter)
+  {
+    if(request->contentType)
+    {
+      requestOutput->print(F("Content-Type: "));
+      requestOutput->print(request->contentType);
+      requestOutput->print(F("\r\n"));
+    }
+    requestOutput->print(F("Content-Length: "));
+    requestOutput->print((unsigned long)contentLength);
+    requestOutput->print(F("\r\n"));
+  }
+  requestOutput->print(F("\r\n"));
+  
+  if(request && request->bodyWriter)
+  {
+    (request->bodyWriter)(requestOutput, request->bodyWriterContext);
+  }
+}
+
+byte ESP8266_Simple::fetchAll(ESP8266_HttpFetch *fetches, byte numFetches, unsigned long maxWaitMillis)
+{
+  byte responseCode;
+  byte done;
+  byte started;
+  
+#if ESP8266_ENABLE_SERVER
+  const byte wasMux = this->httpServerPort ? 1 : 0;
+#else
+  const byte wasMux = 0;
+#endif
+  
+  // Any we don't get to, because no channel was free
+  for(done = 0; done < numFetches; done++)
+  {
+    fetches[done].responseCode = ESP8266_BUSY;
+  }
+  
+  // The server has us in MUX mode already, otherwise it's just for now
+  if(!wasMux && (responseCode = this->sendCommand(F("AT+CIPMUX=1"))) != ESP8266_OK)
+  {
+    for(done = 0; done < numFetches; done++)
+    {
+      fetches[done].responseCode = responseCode;
+    }
+    return responseCode;
+  }
+  
+  for(done = 0; done < numFetches; done += started)
+  {
+    if(!(started = this->fetchBatch(fetches + done, numFetches - done, maxWaitMillis))) break;
+  }
+  
+  if(!wasMux)
+  {
+    this->sendCommand(F("AT+CIPMUX=0"));
+  }
+  
+  for(done = 0; done < numFetches; done++)
+  {
+    if(fetches[done].responseCode != ESP8266_OK) return fetches[done].responseCode;
+  }
+  return ESP8266_OK;
+}
+
+// Start as many of the fetches as there are channels free and see them through,
+// returns how many that was
+byte ESP8266_Simple::fetchBatch(ESP8266_HttpFetch *fetches, byte numFetches, unsigned long maxWaitMillis)
+{
+  char lineBuffer[20];
+  char segmentBuffer[ESP8266_SEND_SEGMENT_SIZE];
+  byte inUse   = this->clientChannels;
+  byte opened  = 0;
+  byte started = 0;
+  int  muxChannel;
+  byte x;
+  ESP8266_HttpFetch *fetch;
+  
+#if ESP8266_ENABLE_SERVER
+  inUse |= this->serverChannels;
+#endif
+  
+  // Connect them all first, nothing can come back until a request is sent.
+  // The server's clients get the lowest free channel, so we start at the top.
+  for(muxChannel = ESP8266_MUX_CHANNELS-1; muxChannel >= 0 && started < numFetches; muxChannel--)
+  {
+    if(inUse & (1 << muxChannel)) continue;
+    
+    fetch = &fetches[started++];
+    fetch->muxChannel       = muxChannel;
+    fetch->parseState       = ESP8266_FETCH_STATUS;
+    fetch->lineLength       = 0;
+    fetch->contentLength    = -1;
+    fetch->bodyLength       = 0;
+    fetch->httpResponseCode = 0;
+    fetch->responseBuffer[0] = 0;
+    
+    fetch->responseCode = this->openConnection(ESP8266_TCP, fetch->serverIp, fetch->port, 0, muxChannel);
+    if(fetch->responseCode == ESP8266_OK) opened |= (1 << muxChannel);
+  }
+  if(!started) return 0;
+  
+  // While the later requests are being sent, responses to the earlier ones 
+  // are already arriving, they are taken out of the way by the serial
+  this->fetches          = fetches;
+  this->numFetches       = started;
+  this->fetchingChannels = opened;
+  this->espSerial->setPacketDiverter(opened, ESP8266_Simple::fetchReceived, this);
+  
+  for(x = 0; x < started; x++)
+  {
+    fetch = &fetches[x];
+    if(fetch->responseCode != ESP8266_OK) continue;
+    
+    ESP8266_SendBuffer requestOutput(this, fetch->muxChannel, segmentBuffer, sizeof(segmentBuffer));
+    this->writeHttpRequest(&requestOutput, fetch->path, fetch->httpHost, fetch->request);
+    if((fetch->responseCode = requestOutput.send()) != ESP8266_OK)
+    {
+      this->fetchingChannels &= ~(1 << fetch->muxChannel);
+    }
+  }
+  
+  // Now all there is to read between the packets are lines like "n,CLOSED", an 
+  // HTTP/1.0 server closes when it's done, unless it gave a Content-Length 
+  // and we have it all already
+  ESP8266_Deadline deadline(maxWaitMillis * 1000UL);
+  while((this->fetchingChannels &= ~this->closedChannels) && !deadline.expired())
+  {
+    if(!this->espSerial->available()) continue;
+    
+    memset(lineBuffer,0,sizeof(lineBuffer));
+    if(!this->espSerial->readBytesUntilAndIncluding('\n', lineBuffer, sizeof(lineBuffer)-1, 1)) continue;
+    this->noteUnsolicited(lineBuffer);
+  }
+  
+  for(x = 0; x < started; x++)
+  {
+    fetch = &fetches[x];
+    
+    if(fetch->responseCode == ESP8266_OK)
+    {
+      if(this->fetchingChannels & (1 << fetch->muxChannel))
+      {
+        fetch->responseCode = ESP8266_TIMEOUT;
+      }
+      else if(fetch->parseState != ESP8266_FETCH_BODY)
+      {
+        // Closed without (all of) the headers
+        fetch->responseCode = ESP8266_ERROR;
+      }
+    }
+    if(fetch->parseState != ESP8266_FETCH_BODY) fetch->responseBuffer[0] = 0;
+    
+    if(fetch->request && fetch->request->responseHeaders)
+    {
+      fetch->request->responseHeaders->contentLength = fetch->contentLength;
+      fetch->request->responseHeaders->bodyLength    = fetch->bodyLength;
+    }
+    
+    if((opened & (1 << fetch->muxChannel)) && !this->isConnectionClosed(fetch->muxChannel))
+    {
+      this->closeConnection(fetch->muxChannel);
+    }
+    this->clientChannels &= ~(1 << fetch->muxChannel);
+  }
+  
+  // Only now, anything still arriving for them is thrown away
+  this->espSerial->setPacketDiverter(0, NULL);
+  this->fetchingChannels = 0;
+  this->fetches          = NULL;
+  this->numFetches       = 0;
+  
+  return started;
+}
+
+void ESP8266_Simple::fetchReceived(int muxChannel, const char *data, int length, void *context)
+{
+  ESP8266_Simple *esp = (ESP8266_Simple *) context;
+  
+  for(byte x = 0; x < esp->numFetches; x++)
+  {
+    if(esp->fetches[x].muxChannel == muxChannel)
+    {
+      esp->parseFetch(&esp->fetches[x], data, length);
+      return;
+    }
+  }
+}
+
+// Each piece of a fetch's response comes here, the status line and headers
+// are put a line at a time in the response buffer (which is not needed
+// until the body starts), the body goes in after them, or to the sink.
+void ESP8266_Simple::parseFetch(ESP8266_HttpFetch *fetch, const char *data, int length)
+{
+  char *line = fetch->responseBuffer;
+  int   fits;
+  
+  for(; length && fetch->parseState != ESP8266_FETCH_BODY; data++, length--)
+  {
+    if(*data != '\n')
+    {
+      if(*data != '\r' && fetch->lineLength < fetch->responseBufferLength-1) line[fetch->lineLength++] = *data;
+      continue;
+    }
+    
+    line[fetch->lineLength] = 0;
+    if(fetch->parseState == ESP8266_FETCH_STATUS)
+    {
+      // HTTP/1.1 200 OK
+      if(strncmp_P(line, PSTR("HTTP/"), 5) == 0 && strchr(line, ' '))
+      {
+        fetch->httpResponseCode = atoi(strchr(line, ' ')+1);
+      }
+      fetch->parseState = ESP8266_FETCH_HEADERS;
+    }
+    else if(!fetch->lineLength)
+    {
+      fetch->parseState = ESP8266_FETCH_BODY;
+    }
+    else
+    {
+      this->parseHeader(line, fetch->contentLength, fetch->request ? fetch->request->responseHeaders : NULL);
+    }
+    
+    fetch->lineLength = 0;
+    line[0] = 0;
+  }
+  
+  if(fetch->parseState != ESP8266_FETCH_BODY) return;
+  
+  if(length)
+  {
+    if(fetch->bodySink)
+    {
+      (*fetch->bodySink)(data, length, fetch->bodySinkContext);
+    }
+    else if(fetch->bodyLength < fetch->responseBufferLength-1)
+    {
+      fits = min((long) length, fetch->responseBufferLength-1 - fetch->bodyLength);
+      memcpy(fetch->responseBuffer + fetch->bodyLength, data, fits);
+      fetch->responseBuffer[fetch->bodyLength + fits] = 0;
+    }
+    fetch->bodyLength += length;
+  }
+  
+  if(fetch->contentLength >= 0 && fetch->bodyLength >= fetch->contentLength)
+  {
+    this->fetchingChannels &= ~(1 << fetch->muxChannel);
+  }
+}
+#endif // ESP8266_ENABLE_HTTP_CLIENT
+
+byte ESP8266_Simple::openConnection(byte type, unsigned long remoteIpAddress, int remotePort, int localPort, int muxChannel)
+{
+  char cmdBuffer[64];    
+  memset(cmdBuffer,0,sizeof(cmdBuffer));
+  
+  if(type == ESP8266_UDP && localPort && this->getFirmwareDialect() != ESP8266_DIALECT_UNKNOWN)
+  {
+    if(!this->hasFeature(ESP8266_FEATURE_UDP_LOCALPORT)) return ESP8266_ERROR;
+  }
+  
+  // sendData() asks if it can use AT+CIPSENDBUF, find out now before there is 
+  // anything in flight for asking to get in the way of
+  if(type == ESP8266_TCP && this->pipelinedSends) this->getFirmwareDialect();
+  
+  this->linkClosed = 0;
+  if(muxChannel >= 0) 
+  {
+    this->closedChannels &= ~(1 << muxChannel);
+    this->clientChannels |= (1 << muxChannel);
+  }
+  
+  // A new connection has nothing queued, and only TCP can use AT+CIPSENDBUF
+  const byte slot = this->sendSlot(muxChannel);
+  this->pendingSends[slot]   = 0;
+  this->pendingSendChannels &= ~(1 << slot);
+  this->failedSendChannels  &= ~(1 << slot);
+  if(type == ESP8266_TCP) this->tcpChannels |=  (1 << slot);
+  else                    this->tcpChannels &= ~(1 << slot);
+  
+  this->invalidateStationCache(ESP8266_CACHE_STATUS);
+  
+  // Build up the command string
+  //  AT+CIPSTART=[MUX,]"TCP","[IP]",[PORT]
+  //  AT+CIPSTART=[MUX,]"UDP","[IP]",[PORT][,LOCALPORT,0]
+  strcpy_P(cmdBuffer, PSTR("AT+CIPSTART="));
+  if(muxChannel >= 0)
+  {
+    itoa(muxChannel, cmdBuffer+strlen(cmdBuffer), 10);
+    cmdBuffer[strlen(cmdBuffer)] = ',';
+  }
+  strcpy_P(cmdBuffer+strlen(cmdBuffer), type == ESP8266_UDP ? PSTR("\"UDP\",\"") : PSTR("\"TCP\",\"")); // Type with opening quote for IP
+  this->ipConvertDatatypeFromTo(remoteIpAddress, cmdBuffer+strlen(cmdBuffer));  // the IP address
+  strcpy(cmdBuffer+strlen(cmdBuffer),"\",");                                    // closing quote for IP
+  itoa(remotePort,cmdBuffer+strlen(cmdBuffer), 10);                             // port  
+  
+  if(type == ESP8266_UDP && localPort)
+  {
+    // Mode 0 means the remote end is fixed, we only receive from it
+    cmdBuffer[strlen(cmdBuffer)] = ',';
+    itoa(localPort,cmdBuffer+strlen(cmdBuffer), 10);
+    strcpy_P(cmdBuffer+strlen(cmdBuffer), PSTR(",0"));
+  }
+  
+  return this->sendCommand(cmdBuffer);
+}
+
+byte ESP8266_Simple::closeConnection(int muxChannel)
+{
+  char cmdBuffer[16];
+  memset(cmdBuffer,0,sizeof(cmdBuffer));
+  
+  // Closing now would throw away anything still queued
+  this->flushSends(muxChannel);
+  
+  strcpy_P(cmdBuffer, PSTR("AT+CIPCLOSE"));
+  if(muxChannel >= 0)
+  {
+    cmdBuffer[strlen(cmdBuffer)] = '=';
+    itoa(muxChannel, cmdBuffer+strlen(cmdBuffer), 10);
+  }
+  
+  return this->sendCommand(cmdBuffer);
+}
+
+void ESP8266_Simple::setDatagramHandler(ESP8266_DatagramHandler datagramHandler, unsigned int maxDatagramSize)
+{
+  this->datagramHandler = datagramHandler;
+  this->datagramMaxSize = maxDatagramSize;
+}
+
+byte ESP8266_Simple::receiveDatagram()
+{
+  this->listen();
+  if(!this->espSerial->available()) return ESP8266_OK; // Nothing to do
+  if(!this->datagramHandler)        return ESP8266_ERROR;
+  
+  char dataBuffer[this->datagramMaxSize+1];
+  int  muxChannel = -1;
+  int  dataLength;
+  
+  // Something is arriving, it's probably the +IPD, we don't wait long for it
+  // to start in case it is just some left over junk
+  if((dataLength = this->readPacket(dataBuffer, sizeof(dataBuffer), &muxChannel, 20)) > 0)
+  {
+    (this->datagramHandler)(dataBuffer, dataLength, muxChannel);
+  }
+  
+  return ESP8266_OK;
+}
+
+// Read one +IPD packet into buffer (null terminated, anything which does not fit
+// is discarded), waiting at most maxWaitMillis for it to start, returns the number
+// of bytes put into the buffer, and sets muxChannel if it was given in the +IPD
+int ESP8266_Simple::readPacket(char *buffer, int bufferLength, int *muxChannel, unsigned long maxWaitMillis)
+{
+  int bytesRead;
+  
+  memset(buffer,0,bufferLength);
+  
+  if(this->readPacketHeader(muxChannel, maxWaitMillis) <= 0) return 0;
+  
+  bytesRead = this->readPacketData(buffer, bufferLength-1);
+  
+  // Throw away anything that didn't fit
+  this->skipPacketData();
+  
+  return bytesRead;
+}
+
+int ESP8266_Simple::readPacketHeader(int *muxChannel, unsigned long maxWaitMillis)
+{
+  char cmdBuffer[40]; // +IPD,4,2048,255.255.255.255,65535:
+  int  bytesRead;
+  int  packetLength = -1;
+  int  packetMux;
+  int  cmdBufferIndex;
+  unsigned long startTime = millis();
+  
+  this->packetRemaining = 0;
+  
+  do
+  {
+    if(!this->espSerial->available()) continue;
+    
+    memset(cmdBuffer,0,sizeof(cmdBuffer));
+    bytesRead = this->espSerial->readBytesUntilAndIncluding(':', cmdBuffer, sizeof(cmdBuffer)-1, 1);
+    
+    // Looking for +IPD[,mux#],1234: anything else is skipped
+    if(bytesRead < 7 || cmdBuffer[bytesRead-1] != ':') 
+    {
+      if(cmdBuffer[1] != ',' && this->isClosedResponse(cmdBuffer)) this->linkClosed = 1;
+      this->noteUnsolicited(cmdBuffer);
+      continue;
+    }
+    
+    for(cmdBufferIndex = 0; cmdBufferIndex < bytesRead-4; cmdBufferIndex++)
+    {
+      if(strncmp_P(cmdBuffer+cmdBufferIndex, PSTR("+IPD,"), 5) == 0) break;
+    }
+    if(cmdBufferIndex >= bytesRead-4) continue;
+    packetMux = this->parseIPD(cmdBuffer+cmdBufferIndex+5, packetLength);
+    if(muxChannel && packetMux >= 0) *muxChannel = packetMux;
+    break;
+  } while(millis() - startTime < maxWaitMillis);
+  
+  if(packetLength <= 0) return 0;
+  
+  this->packetRemaining = packetLength;
+  return packetLength;
+}
+
+int ESP8266_Simple::readPacketData(char *buffer, int length)
+{
+  int bytesRead = this->espSerial->readBytes(buffer, min(this->packetRemaining, length));
+  
+  this->packetRemaining -= bytesRead;
+  if(bytesRead < length) this->packetRemaining = 0; // Timed out, the rest isn't coming
+  
+  return bytesRead;
+}
+
+void ESP8266_Simple::skipPacketData()
+{
+  for(; this->packetRemaining > 0; this->packetRemaining--)
+  {
+    if(this->espSerial->waitUntilAvailable() == 0) break;
+    this->espSerial->read();
+  }
+  this->packetRemaining = 0;
+}
+
+byte ESP8266_Simple::isConnectionClosed(int muxChannel)
+{
+  if(muxChannel < 0) return this->linkClosed;
+  
+  return (this->closedChannels & (1 << muxChannel)) ? 1 : 0;
+}
+
+byte ESP8266_Simple::sendData(int muxChannel, const char *data, int length)
+{
+  return this->sendData(muxChannel, NULL, data, length);
+}
+
+// As above, the header (if any) goes first in the same segment
+byte ESP8266_Simple::sendData(int muxChannel, const char *header, const char *data, int length)
+{
+  char cmdBuffer[24];
+  byte responseCode;
+  int  headerLength = header ? strlen(header) : 0;
+  
+  // Segments to TCP connections can be queued without waiting for each to be 
+  // sent, if the firmware knows how
+  const byte pipelined = this->canPipeline(muxChannel);
+  const byte slot      = this->sendSlot(muxChannel);
+  
+  if(pipelined)
+  {
+    // A segment we queued earlier didn't make it
+    if(this->failedSendChannels & (1 << slot))
+    {
+      this->failedSendChannels &= ~(1 << slot);
+      return ESP8266_ERROR;
+    }
+    
+    // Don't get too far ahead of it
+    if((responseCode = this->waitForSegments(muxChannel, ESP8266_SENDBUF_MAX_PENDING - 1)) != ESP8266_OK)
+    {
+      return responseCode;
+    }
+  }
+  
+  memset(cmdBuffer,0,sizeof(cmdBuffer));
+  strcpy_P(cmdBuffer, pipelined ? PSTR("AT+CIPSENDBUF=") : PSTR("AT+CIPSEND="));
+  if(muxChannel >= 0)
+  {
+    itoa(muxChannel, cmdBuffer+strlen(cmdBuffer), 10);
+    cmdBuffer[strlen(cmdBuffer)] = ',';
+  }
+  itoa(headerLength + length, cmdBuffer+strlen(cmdBuffer), 10);
+  
+  // We don't use sendCommand() here because the "> " prompt has no line ending, 
+  // waiting for the line to end costs us the full serial timeout every time.
+  this->clearSerialBuffer();
+  ESP82336_DEBUGLN();
+  ESP82336_DEBUG("SEND {{{");
+  ESP82336_DEBUG(cmdBuffer);
+  ESP82336_DEBUGLN("}}}");
+  this->espSerial->println(cmdBuffer);
+  
+  if((responseCode = this->waitForPrompt()) != ESP8266_OK)
+  {
+    return responseCode;
+  }
+  
+  if(header) this->espSerial->print(header);
+  this->espSerial->write((const uint8_t *)data, length);
+  
+  if(pipelined)
+  {
+    // "Recv n bytes" means it is queued, "[n,]segment,SEND OK" comes later
+    if((responseCode = this->waitForLine(PSTR("Recv"))) == ESP8266_OK)
+    {
+      this->pendingSends[slot]++;
+      this->pendingSendChannels |= (1 << slot);
+    }
+    return responseCode;
+  }
+  
+  return this->waitForLine(PSTR("SEND OK"));
+}
+
+void ESP8266_Simple::setPipelinedSends(byte enabled)
+{
+  this->pipelinedSends = enabled;
+}
+
+byte ESP8266_Simple::flushSends(int muxChannel)
+{
+  byte responseCode;
+  
+  if(muxChannel >= ESP8266_MUX_CHANNELS) return ESP8266_OK;
+  
+  const byte slot = this->sendSlot(muxChannel);
+  responseCode = this->waitForSegments(muxChannel, 0);
+  if(this->failedSendChannels & (1 << slot))
+  {
+    this->failedSendChannels &= ~(1 << slot);
+    return ESP8266_ERROR;
+  }
+  
+  return responseCode;
+}
+
+// The single connection (not MUX mode) gets the slot after the channels
+byte ESP8266_Simple::sendSlot(int muxChannel)
+{
+  return muxChannel >= 0 ? muxChannel : ESP8266_MUX_CHANNELS;
+}
+
+byte ESP8266_Simple::canPipeline(int muxChannel)
+{
+  byte tcpChannels = this->tcpChannels;
+  
+#if ESP8266_ENABLE_SERVER
+  tcpChannels |= this->serverChannels;
+#endif
+  
+  return this->pipelinedSends 
+      && muxChannel < ESP8266_MUX_CHANNELS
+      && (tcpChannels & (1 << this->sendSlot(muxChannel)))
+      && this->hasFeature(ESP8266_FEATURE_SENDBUF);
+}
+
+void ESP8266_Simple::segmentSent(int muxChannel, byte sentOk)
+{
+  if(muxChannel >= ESP8266_MUX_CHANNELS) return;
+  
+  const byte slot = this->sendSlot(muxChannel);
+  if(this->pendingSends[slot] && !--this->pendingSends[slot])
+  {
+    this->pendingSendChannels &= ~(1 << slot);
+  }
+  
+  if(!sentOk)
+  {
+    this->failedSendChannels |= (1 << slot);
+  }
+}
+
+// Read lines (they are all handled by noteUnsolicited()) until no more than
+// maxPending segments on this connection are still to be acknowledged, each 
+// acknowledgement gets a fresh timeout
+byte ESP8266_Simple::waitForSegments(int muxChannel, byte maxPending)
+{
+  char lineBuffer[20];
+  const byte slot = this->sendSlot(muxChannel);
+  byte pending = this->pendingSends[slot];
+  ESP8266_Deadline deadline(this->getCommandTimeout(ESP8266_COMMAND_SEND));
+  
+  while(this->pendingSends[slot] > maxPending)
+  {
+    if(this->isConnectionClosed(muxChannel)) return ESP8266_ERROR;
+    if(deadline.expired())
+    {
+      ESP82336_DEBUGLN("TIMED OUT WAITING FOR SEND OK");
+      return ESP8266_TIMEOUT;
+    }
+    
+    if(!this->espSerial->available()) continue;
+    
+    memset(lineBuffer,0,sizeof(lineBuffer));
+    if(!this->espSerial->readBytesUntilAndIncluding('\n', lineBuffer, sizeof(lineBuffer)-1, 1)) continue;
+    ESP82336_DEBUG(lineBuffer);
+    this->noteUnsolicited(lineBuffer);
+    
+    if(this->pendingSends[slot] < pending)
+    {
+      pending = this->pendingSends[slot];
+      deadline.restart();
+    }
+  }
+  
+  return ESP8266_OK;
+}
+
+// Wait for the "> " prompt which follows AT+CIPSEND, an "ERROR" (or similar) 
+// line instead means we won't be getting one.
+byte ESP8266_Simple::waitForPrompt()
+{
+  char lineBuffer[12];
+  byte lineIndex = 0;
+  int  c;
+  ESP8266_Deadline deadline(this->getCommandTimeout(ESP8266_COMMAND_SEND));
+  
+  memset(lineBuffer,0,sizeof(lineBuffer));
+  do
+  {
+    if(!this->espSerial->available()) continue;
+    
+    c = this->espSerial->read();
+    if(c == '>') return ESP8266_OK;
+    
+    if(c == '\n')
+    {
+      if(strncmp_P(lineBuffer, PSTR("ERROR"),       5) == 0) return ESP8266_ERROR;
+      if(strncmp_P(lineBuffer, PSTR("link is not"), 11) == 0) return ESP8266_ERROR;
+      if(strncmp_P(lineBuffer, PSTR("busy"),        4) == 0) return ESP8266_BUSY;
+      this->noteUnsolicited(lineBuffer);
+      
+      memset(lineBuffer,0,sizeof(lineBuffer));
+      lineIndex = 0;
+    }
+    else if(lineIndex < sizeof(lineBuffer)-1)
+    {
+      lineBuffer[lineIndex++] = c;
+    }
+  } while(!deadline.expired());
+  
+  ESP82336_DEBUGLN("TIMED OUT WAITING FOR PROMPT");
+  return ESP8266_TIMEOUT;
+}
+
+// Read lines until one starts with expectedLine (a PSTR), or an error 
+// line is seen, other lines are discarded.
+byte ESP8266_Simple::waitForLine(const char *expectedLine)
+{
+  char lineBuffer[16];
+  ESP8266_Deadline deadline(this->getCommandTimeout(ESP8266_COMMAND_SEND));
+  
+  do
+  {
+    if(!this->espSerial->available()) continue;
+    
+    memset(lineBuffer,0,sizeof(lineBuffer));
+    if(!this->espSerial->readBytesUntilAndIncluding('\n', lineBuffer, sizeof(lineBuffer)-1, 1)) continue;
+    ESP82336_DEBUG(lineBuffer);
+    this->noteUnsolicited(lineBuffer);
+    
+    if(strncmp_P(lineBuffer, expectedLine, strlen_P(expectedLine)) == 0) return ESP8266_OK;
+    if(strncmp_P(lineBuffer, PSTR("ERROR"),     5) == 0) return ESP8266_ERROR;
+    if(strncmp_P(lineBuffer, PSTR("SEND FAIL"), 9) == 0) return ESP8266_ERROR;
+    
+  } while(!deadline.expired());
+  
+  ESP82336_DEBUGLN("TIMED OUT");
+  return ESP8266_TIMEOUT;
+}
+
+ESP8266_SendBuffer::ESP8266_SendBuffer(ESP8266_Simple *esp, int muxChannel, char *buffer, int bufferSize)
+{
+  this->esp          = esp;
+  this->muxChannel   = muxChannel;
+  this->buffer       = buffer;
+  this->bufferSize   = bufferSize;
+  this->bufferIndex  = 0;
+  this->responseCode = ESP8266_OK;
+}
+
+size_t ESP8266_SendBuffer::write(uint8_t c)
+{
+  if(this->responseCode != ESP8266_OK) return 0;
+  
+  this->buffer[this->bufferIndex++] = c;
+  if(this->bufferIndex >= this->bufferSize)
+  {
+    this->send();
   }
   
-  if(this->unlinkConnection() != ESP8266_OK)
+  return 1;
+}
+
+byte ESP8266_SendBuffer::send()
+{
+  if(this->bufferIndex && this->responseCode == ESP8266_OK)
   {
-    this->reset();
+    this->responseCode = this->esp->sendData(this->muxChannel, this->buffer, this->bufferIndex);
   }
-  this->sendCommand(F("AT+CIPSTATUS"));
-  return ESP8266_OK;    
+  this->bufferIndex = 0;
+  
+  return this->responseCode;
 }
 
-unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLength, int bodyResponseOnlyFromLine, int *parseHttpResponse, int *muxChannel)
+unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLength, int bodyResponseOnlyFromLine, int *parseHttpResponse, int *muxChannel, ESP8266_HttpHeaders *responseHeaders)
 {  
   if(!this->espSerial->waitUntilAvailable()) return 0;
   
@@ -677,12 +2898,21 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
   int cmdBufferIndex          = 0;
   int responseBufferIndex     = 0;    
   int packetLength            = -1;
+  int packetMux;
   int bytesRead               = 0;
   int lineNumber              = -1;
   int packetCount             = 0;
   
   // For HTTP parsing only
   byte headerEnd              = 0;
+  byte inBody                 = 0;   // Past the blank line after the headers
+  byte lineStart              = 1;   // The next read starts a new line
+  long contentLength          = -1;  // From the Content-Length header, if there is one
+  long bodyLength             = 0;   // How much of the body we have read (kept or not)
+  char *chunk;
+  
+  this->bodyComplete = 0;
+  if(responseHeaders) responseHeaders->contentLength = responseHeaders->rangeTotal = -1;
  
   do
   {
@@ -708,31 +2938,35 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
         if(cmdBuffer[bytesRead-1] == ':')
         {
           // There might be whitespace at the start of this line, we are looking at 
-          //  +IPD[,mux#],1234
-          //  where 1234 is the number of bytes to follow, 
-          //  so we will walk backwards to find the , and then from that point forward
-          //  convert to an integer
-          for(cmdBufferIndex = bytesRead-1; cmdBufferIndex >= 0; cmdBufferIndex--)
+          //  +IPD[,mux#],1234[,ip,port]
+          //  where 1234 is the number of bytes to follow
+          for(cmdBufferIndex = 0; cmdBufferIndex < bytesRead-5; cmdBufferIndex++)
           {
-            if(cmdBuffer[cmdBufferIndex-1] == ',') break;
+            if(strncmp_P(cmdBuffer+cmdBufferIndex, PSTR("+IPD,"), 5) == 0) break;
           }
-          packetLength = atoi(cmdBuffer+cmdBufferIndex);   
+          packetMux = this->parseIPD(cmdBuffer+cmdBufferIndex+5, packetLength);
           packetCount++;
         
-          // We also might want to find a mux channel
-          for(cmdBufferIndex = cmdBufferIndex-2; cmdBufferIndex >= 0; cmdBufferIndex--)
+#if ESP8266_ENABLE_WEBSOCKET
+          // A packet on a WebSocket isn't HTTP, it's frames, deal with them and we're done
+          if(packetMux >= 0 && this->webSocketChannels && (this->webSocketChannels & (1 << packetMux)))
           {
-            if(cmdBuffer[cmdBufferIndex-1] == ',') break;
-          }                    
-          if(cmdBufferIndex)
+            this->receiveWebSocket(packetMux, packetLength);
+            packetLength = -1;
+            break;
+          }
+#endif
+          
+          if(packetMux >= 0)
           {
             // If we get a mux channel, compare it to the request one, if it 
             // isn't a match, skip this packet (but we keep the packetCount)
-            if(muxChannel && (*muxChannel < 0)) *muxChannel = atoi(cmdBuffer+cmdBufferIndex);
-            else if(muxChannel && (*muxChannel != atoi(cmdBuffer+cmdBufferIndex)))
+            if(muxChannel && (*muxChannel < 0)) *muxChannel = packetMux;
+            else if(muxChannel && (*muxChannel != packetMux))
             {
               // ignore this packet, it's not for us
-              this->clearSerialBuffer();
+              this->packetRemaining = packetLength;
+              this->skipPacketData();
               packetLength = -1;
             }
           }
@@ -744,16 +2978,15 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
         {
           // fall through for next packet
         }
-        else if(cmdBuffer[0] == 'U' && cmdBuffer[5] == 'k') // "Unlink" - signals end of stream  0.9.2.4
-        {
-          break;
-        }
-        else if(cmdBuffer[0] == 'C' && cmdBuffer[5] == 'D') // "CLOSED" - signals end of stream 0.9.5.2
+        else if(this->isClosedResponse(cmdBuffer)) // "Unlink" (0.9.2.4) or "CLOSED" - signals end of stream
         {
+          this->linkClosed = 1;
+          this->noteUnsolicited(cmdBuffer);
           break;
         }
         else
         {
+          this->noteUnsolicited(cmdBuffer);
           ESP82336_DEBUG("Unknown IPD?:  ");
           ESP82336_DEBUGLN(cmdBuffer);
           break;
@@ -772,6 +3005,30 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
       // finish up now and discard everything
       if(min(packetLength,responseBufferLength-responseBufferIndex-1) <= 0)
       {
+#if ESP8266_ENABLE_SERVER
+        // The buffer is full, but the WebSocket key (or If-None-Match) may be 
+        // further down the headers, read on a line at a time until we find it 
+        // or they end
+        byte wantHeaders = this->ifNoneMatch && !this->ifNoneMatch[0];
+#if ESP8266_ENABLE_WEBSOCKET
+        wantHeaders = wantHeaders || (this->webSocketKey && !this->webSocketKey[0]);
+#endif
+        if(packetLength > 0 && wantHeaders)
+        {
+          memset(cmdBuffer,0,sizeof(cmdBuffer));
+          bytesRead = this->espSerial->readBytesUntilAndIncluding('\n', cmdBuffer, min(packetLength, (int) sizeof(cmdBuffer)-1));
+          packetLength -= bytesRead;
+          
+          if(bytesRead > 2) // "\r\n" is the end of the headers
+          {
+#if ESP8266_ENABLE_WEBSOCKET
+            if(this->webSocketKey) this->captureWebSocketKey(cmdBuffer);
+#endif
+            this->captureRequestHeader(cmdBuffer);
+            continue;
+          }
+        }
+#endif
         break;
       }
       
@@ -783,7 +3040,44 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
       ESP82336_DEBUGLN("READ BYTES");
       
       // Read up to the next newline, or all the remaining response, or as much as we can fit in the buffer, whichever comes first      
-      bytesRead = this->espSerial->readBytesUntilAndIncluding('\n', responseBuffer+responseBufferIndex, min(packetLength,responseBufferLength-responseBufferIndex-1));
+      chunk     = responseBuffer+responseBufferIndex;
+      bytesRead = this->espSerial->readBytesUntilAndIncluding('\n', chunk, min(packetLength,responseBufferLength-responseBufferIndex-1));
+      
+#if ESP8266_ENABLE_WEBSOCKET
+      if(this->webSocketKey && lineStart)
+      {
+        this->captureWebSocketKey(chunk);
+      }
+#endif
+      
+#if ESP8266_ENABLE_SERVER
+      if(this->capturingRequest && lineStart)
+      {
+        this->captureRequestHeader(chunk);
+      }
+#endif
+      
+      // Once we know there is an HTTP response (the status line is line 1) look 
+      // through the headers as they go past for the ones we want, and count 
+      // the body so we know when we have it all
+      if(inBody)
+      {
+        bodyLength += bytesRead;
+      }
+      else if(lineStart && lineNumber != -1 && parseHttpResponse && *parseHttpResponse)
+      {
+        if(chunk[0] == '\n' || (chunk[0] == '\r' && chunk[1] == '\n'))
+        {
+          inBody = 1;
+        }
+#if ESP8266_ENABLE_HTTP_CLIENT
+        else
+        {
+          this->parseHeader(chunk, contentLength, responseHeaders);
+        }
+#endif
+      }
+      lineStart = (bytesRead && chunk[bytesRead-1] == '\n');
       
       ESP82336_DEBUGLN("DONE READING");
       
@@ -801,7 +3095,7 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
         // First line of first packet should be status code (hopefully nobody out there has preceeding whitespace)
         if(parseHttpResponse)
         {
-          if(strcmp_P(responseBuffer, PSTR("HTTP/")) == 0)
+          if(strncmp_P(responseBuffer, PSTR("HTTP/"), 5) == 0)
           {
             *parseHttpResponse = atoi(responseBuffer+9); // 9 == strlen("HTTP/1.1 ")
           }
@@ -827,7 +3121,7 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
         {
           // \r\n\r\n is found          
           headerEnd = true;
-          memset(responseBuffer,0,responseBufferLength);
+          memset(responseBuffer,0,responseBufferIndex);
           responseBufferIndex = 0;  
           lineNumber = 1;
         }
@@ -882,7 +3176,8 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
           lineNumber++;
         }
         
-        memset(responseBuffer,0,responseBufferLength);
+        // Everything past the index is still clear from before
+        memset(responseBuffer,0,responseBufferIndex);
         responseBufferIndex = 0;        
       }
       else if(bodyResponseOnlyFromLine < 0)
@@ -901,6 +3196,13 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
       }
      
       
+      // We have the whole body, there's no need to wait around for the close
+      if(inBody && contentLength >= 0 && bodyLength >= contentLength)
+      {
+        this->bodyComplete = 1;
+        break;
+      }
+      
       // If there is room in the buffer and more to be got, try to get more
       if(packetLength > 0 && responseBufferIndex < (responseBufferLength - 1))
       {   
@@ -920,44 +3222,124 @@ unsigned int ESP8266_Simple::readIPD(char *responseBuffer, int responseBufferLen
   while(millis() - startTime < (packetCount ? firstPacketWait : (this->generalCommandTimeoutMicroseconds/1000))); //  Timeout to go here
   
   ESP82336_DEBUGLN("READING AL DONE");
+  if(responseHeaders)
+  {
+    responseHeaders->contentLength = contentLength;
+    responseHeaders->bodyLength    = bodyLength;
+  }
   return responseBufferIndex;
 }
 
+#if ESP8266_ENABLE_HTTP_CLIENT
+// Look at one response header line, Content-Length we always want, the others
+// only if there is somewhere to put them
+void ESP8266_Simple::parseHeader(const char *line, long &contentLength, ESP8266_HttpHeaders *responseHeaders)
+{
+  switch(line[0] | 0x20) // lower case
+  {
+    case 'c':
+      if(strncasecmp_P(line, PSTR("Content-Length:"), 15) == 0)
+      {
+        contentLength = atol(line+15);
+      }
+      else if(responseHeaders && strncasecmp_P(line, PSTR("Content-Type:"), 13) == 0)
+      {
+        this->copyHeaderValue(line+13, responseHeaders->contentType, responseHeaders->contentTypeSize);
+      }
+      else if(responseHeaders && strncasecmp_P(line, PSTR("Content-Range:"), 14) == 0)
+      {
+        // bytes 0-99/1234, the total can be "*" if the server doesn't know
+        const char *total = strchr(line, '/');
+        if(total && isdigit(total[1])) responseHeaders->rangeTotal = atol(total+1);
+      }
+      break;
+      
+    case 'e':
+      if(responseHeaders && strncasecmp_P(line, PSTR("ETag:"), 5) == 0)
+      {
+        this->copyHeaderValue(line+5, responseHeaders->etag, responseHeaders->etagSize);
+      }
+      break;
+      
+    case 'l':
+      if(responseHeaders && strncasecmp_P(line, PSTR("Location:"), 9) == 0)
+      {
+        this->copyHeaderValue(line+9, responseHeaders->location, responseHeaders->locationSize);
+      }
+      else if(responseHeaders && strncasecmp_P(line, PSTR("Last-Modified:"), 14) == 0)
+      {
+        this->copyHeaderValue(line+14, responseHeaders->lastModified, responseHeaders->lastModifiedSize);
+      }
+      break;
+      
+    case 'd':
+      if(responseHeaders && strncasecmp_P(line, PSTR("Date:"), 5) == 0)
+      {
+        this->copyHeaderValue(line+5, responseHeaders->date, responseHeaders->dateSize);
+      }
+      break;
+  }
+}
+
+void ESP8266_Simple::copyHeaderValue(const char *value, char *slot, byte slotSize)
+{
+  byte i;
+  
+  if(!slot || !slotSize) return;
+  
+  while(*value == ' ') value++;
+  for(i = 0; i < slotSize-1 && value[i] && value[i] != '\r' && value[i] != '\n'; i++)
+  {
+    slot[i] = value[i];
+  }
+  slot[i] = 0;
+}
+#endif // ESP8266_ENABLE_HTTP_CLIENT
+
 byte ESP8266_Simple::unlinkConnection()
 {
-  char cmdBuffer[8];
+  char cmdBuffer[12];
   memset(cmdBuffer, 0, sizeof(cmdBuffer));
   ESP82336_DEBUGLN();
   ESP82336_DEBUGLN("UNLINKING");
+  
+  // If readIPD() already saw it close, there is nothing more to wait for
+  if(this->linkClosed)
+  {
+    this->linkClosed = 0;
+    this->invalidateStationCache(ESP8266_CACHE_STATUS);
+    return ESP8266_OK;
+  }
+  
   // Blindly send a CIPCLOSE to try and kill the connection now
   // NOTE: Nope, this tends to cause the ESP to crash out
   // this->espSerial->println(F("AT+CIPCLOSE"));
+  //
+  // Later firmware is fine with it though, and when we already have the whole
+  // body (see Content-Length in readIPD()) it saves waiting for the server
+  if(this->bodyComplete && this->firmwareDialect > ESP8266_DIALECT_0924)
+  {
+    this->bodyComplete = 0;
+    this->sendCommand(F("AT+CIPCLOSE")); // If it already closed we get an ERROR, no matter
+    this->linkClosed = 0;
+    this->invalidateStationCache(ESP8266_CACHE_STATUS);
+    return ESP8266_OK;
+  }
 
-  // Dump everything else until we see "Unlink" or nothing else seems to be available
+  // Dump everything else until we see "Unlink" (or "CLOSED") or nothing else seems to be available
   do
   {    
+    memset(cmdBuffer, 0, sizeof(cmdBuffer));
     if(this->espSerial->waitUntilAvailable() == 0 || !this->espSerial->readBytesUntilAndIncluding('\n', cmdBuffer, sizeof(cmdBuffer)-1))
     {   
       return ESP8266_TIMEOUT;      // Caller might want to do a reset()
     }
     ESP82336_DEBUG(cmdBuffer);
-  } while( // We really need to keep up and not have any overflow, so not using string comparison here
-    cmdBuffer[0] != 'U' || 
-    cmdBuffer[1] != 'n' || 
-    cmdBuffer[2] != 'l' || 
-    cmdBuffer[3] != 'i' || 
-    cmdBuffer[4] != 'n' || 
-    cmdBuffer[5] != 'k'
-  );
-  
-  if(strncmp_P(cmdBuffer, PSTR("Unlink"), 6) == 0)
-  {    
-    return ESP8266_OK;
-  }
-  else
-  {
-    return ESP8266_ERROR;
-  }
+    this->noteUnsolicited(cmdBuffer);
+  } while(!this->isClosedResponse(cmdBuffer));
+  
+  this->invalidateStationCache(ESP8266_CACHE_STATUS);
+  return ESP8266_OK;
 }
 
 void ESP8266_Simple::ipConvertDatatypeFromTo(const char *ipAddressString, unsigned long &ipAddressLong)
@@ -1039,12 +3421,47 @@ byte ESP8266_Simple::sendCommand(const __FlashStringHelper *cmd, char *responseB
 
 // Send command and get response into a buffer
 byte ESP8266_Simple::sendCommand(const char **cmdPartsToConcatenate, byte numParts, char *responseBuffer, int responseBufferLength, byte getResponseFromLine)
+{
+  byte commandClass = this->commandClassOf(cmdPartsToConcatenate[0]);
+  ESP8266_Deadline deadline(this->getCommandTimeout(commandClass));
+  
+  byte responseCode = this->sendCommandParts(cmdPartsToConcatenate, numParts, responseBuffer, responseBufferLength, getResponseFromLine, deadline);
+#if ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+  this->noteLatency(commandClass, deadline.elapsed(), responseCode);
+#endif
+  this->noteHealth(responseCode);
+  
+  // Echo comes back on after a reset, now we know it's listening again turn it 
+  // off (not after a SEND, the OK may be a prompt waiting for data)
+  if(responseCode == ESP8266_OK && this->echoState == ESP8266_ECHO_UNKNOWN && commandClass == ESP8266_COMMAND_QUICK)
+  {
+    this->disableEcho();
+  }
+  
+  return responseCode;
+}
+
+// Stop the device echoing back everything we send, which halves what we have
+// to read back for every command
+byte ESP8266_Simple::disableEcho()
+{
+  // So we don't try again while doing it
+  this->echoState = ESP8266_ECHO_OFF;
+  
+  byte responseCode = this->sendCommand(F("ATE0"));
+  if(responseCode == ESP8266_ERROR)   this->echoState = ESP8266_ECHO_ON;
+  else if(responseCode != ESP8266_OK) this->echoState = ESP8266_ECHO_UNKNOWN;
+  
+  return responseCode;
+}
+
+byte ESP8266_Simple::sendCommandParts(const char **cmdPartsToConcatenate, byte numParts, char *responseBuffer, int responseBufferLength, byte getResponseFromLine, ESP8266_Deadline &deadline)
 {
   char statusBuffer[64];
-  unsigned long waitingMicroSeconds = 0;
   int  responseBufferIndex = 0;
   byte statusBufferIndex   = 0;
   byte responseLineNum     = 0;
+  byte inEcho              = 0;
   int bytesRead            = 0;
   
   // Clear response buffer
@@ -1066,16 +3483,21 @@ byte ESP8266_Simple::sendCommand(const char **cmdPartsToConcatenate, byte numPar
   {
     ESP82336_DEBUG(cmdPartsToConcatenate[bytesRead]);
     this->espSerial->print((const char *)cmdPartsToConcatenate[bytesRead]);
-    this->clearSerialBuffer(); // The character echo will fill up the buffer and overflow, we just clear them out.
-                               // the last println() we keave so that we don't accidentally clear any response.
+    
+    // If echo is on, it will fill up the buffer and overflow, we just clear it out
+    // (the last println() we leave so that we don't accidentally clear any response)
+    if(this->echoState != ESP8266_ECHO_OFF) this->clearSerialBuffer();
   }  
   this->espSerial->println();
   ESP82336_DEBUGLN("}}}");
   bytesRead = 0;
+  
+  // The time to send the command doesn't count, only the time to answer it
+  deadline.restart();
     
   do
   {
-    #if ESP8266_SERIALMODE == ESP8266_SOFTWARESERIAL
+    #if ESP8266_SERIALMODE != ESP8266_HARDWARESERIAL
       // There is no overflow() in the HardwareSerial code, guess we'll just
       // hope it never happens
       if(this->espSerial->overflow())
@@ -1089,125 +3511,122 @@ byte ESP8266_Simple::sendCommand(const char **cmdPartsToConcatenate, byte numPar
     if(this->espSerial->available())
     {
       memset(statusBuffer,0,sizeof(statusBuffer));
-      if(!responseLineNum)
+      if((bytesRead = this->espSerial->readBytesUntil('\n',statusBuffer,sizeof(statusBuffer)-1)))
       {
-        // read bytes up until the first \n and discard them, this is just the echo
-        // incidentally, the echo contains the string sent, including the CR but not the LF, 
-        // followed by a second CRLF pair, eg if you send
-        // AT+RST[CR][LF] the first response back is
-        // AT+RST[CR][CR][LF]
-        // the [CR] you send actually seems to form part of the command (if no CR is sent, 
-        // the command is not successful, if no LF is sent, the command is not even attempted      
-        if((bytesRead = this->espSerial->readBytesUntil('\n',statusBuffer,sizeof(statusBuffer)-1)))
-        {        
-          ESP82336_DEBUG("DISCARD: "); ESP82336_DEBUG(statusBuffer);
-          
-          // readBytesUntil does NOT include the terminator, conveniently as we are getting
-          // CRLF termination, we can check for the CR instead.
-          if(statusBuffer[bytesRead-1] == '\r')
-          {       
-            ESP82336_DEBUG('\n');
-            responseLineNum = 1;                    
-          }
-        }      
-      }
-      else
-      {      
-        // Fill status buffer
-        if((bytesRead = this->espSerial->readBytesUntil('\n',statusBuffer,sizeof(statusBuffer)-1)))
+        ESP82336_DEBUG(statusBuffer);
+        if(statusBuffer[bytesRead-1] == '\r')
+        {
+          ESP82336_DEBUG('\n');
+        }
+        
+        if(!responseLineNum)
         {
-          ESP82336_DEBUG(statusBuffer);
-          if(statusBuffer[bytesRead-1] == '\r')
+          // The answer starts with a blank line, unless echo is on (it is after 
+          // a reset until we turn it off again, or if the firmware won't) in which
+          // case it starts with what we sent, eg if you send AT+RST[CR][LF] the 
+          // first line back is AT+RST[CR][CR][LF], either way it's not the answer.
+          // Once we know echo is off only the blank line is thrown away, the 
+          // answer might start like what we sent.
+          byte discard = (statusBuffer[0] == '\r');
+          if(this->echoState != ESP8266_ECHO_OFF)
           {
-            ESP82336_DEBUG('\n');
+            discard = discard || inEcho || strncmp(statusBuffer, cmdPartsToConcatenate[0], min((size_t) bytesRead, strlen(cmdPartsToConcatenate[0]))) == 0;
           }
           
-          if(strncmp_P(statusBuffer, PSTR("SEND OK"),  7) == 0) return ESP8266_OK;
-          if(strncmp_P(statusBuffer, PSTR("OK"),       2) == 0) return ESP8266_OK;
-          
-          if(strncmp_P(statusBuffer, PSTR(">"),        1) == 0) return ESP8266_OK;
-          if(strncmp_P(statusBuffer, PSTR("ERROR"),    5) == 0) return ESP8266_ERROR;                                
-          if(strncmp_P(statusBuffer, PSTR("nochange"), 8) == 0) return ESP8266_OK;         
-          if(strncmp_P(statusBuffer, PSTR("no change"),9) == 0) return ESP8266_OK;         
-          if(strncmp_P(statusBuffer, PSTR("ready"),    5) == 0) return ESP8266_READY;            
-          if(strncmp_P(statusBuffer, PSTR("busy"),     4) == 0) return ESP8266_BUSY;    
-          if(strncmp_P(statusBuffer, PSTR("Unlink"),   6) == 0) return ESP8266_OK;
-          if(strncmp_P(statusBuffer, PSTR("Link is builded"), 15) == 0) return ESP8266_OK;
-          
-          // Not sure about this, it appears to happen
-          //   when you issue CIPCLOSE but the browser/client has already 
-          //   closed the connection.  I think.
-          if(strncmp_P(statusBuffer, PSTR("link is not"), 11) == 0) return ESP8266_OK; 
-                                                
-          // If we are using a response buffer, and we have reached the start line
-          // requested (defaults to line 1)        
-          if(responseBufferLength && ( getResponseFromLine <= responseLineNum))
-          {      
-            // If there is room in the response buffer less one byte, copy the statusbuffer there
-            if(responseBufferIndex < responseBufferLength-1)
+          if(discard)
+          {
+            ESP82336_DEBUG("DISCARDED");
+            inEcho = (statusBuffer[bytesRead-1] != '\r');
+            if(!inEcho) responseLineNum = 1;
+            continue;
+          }
+          responseLineNum = 1;
+        }
+        
+        this->noteUnsolicited(statusBuffer);
+        
+        if(strncmp_P(statusBuffer, PSTR("SEND OK"),  7) == 0) return ESP8266_OK;
+        if(strncmp_P(statusBuffer, PSTR("OK"),       2) == 0) return ESP8266_OK;
+        
+        if(strncmp_P(statusBuffer, PSTR(">"),        1) == 0) return ESP8266_OK;
+        if(strncmp_P(statusBuffer, PSTR("ERROR"),    5) == 0) return ESP8266_ERROR;                                
+        if(strncmp_P(statusBuffer, PSTR("nochange"), 8) == 0) return ESP8266_OK;         
+        if(strncmp_P(statusBuffer, PSTR("no change"),9) == 0) return ESP8266_OK;         
+        if(strncmp_P(statusBuffer, PSTR("ready"),    5) == 0) return ESP8266_READY;            
+        if(strncmp_P(statusBuffer, PSTR("busy"),     4) == 0) return ESP8266_BUSY;    
+        if(strncmp_P(statusBuffer, PSTR("Unlink"),   6) == 0) return ESP8266_OK;
+        if(strncmp_P(statusBuffer, PSTR("Link is builded"), 15) == 0) return ESP8266_OK;
+        
+        // Not sure about this, it appears to happen
+        //   when you issue CIPCLOSE but the browser/client has already 
+        //   closed the connection.  I think.
+        if(strncmp_P(statusBuffer, PSTR("link is not"), 11) == 0) return ESP8266_OK; 
+                                              
+        // If we are using a response buffer, and we have reached the start line
+        // requested (defaults to line 1)        
+        if(responseBufferLength && ( getResponseFromLine <= responseLineNum))
+        {      
+          // If there is room in the response buffer less one byte, copy the statusbuffer there
+          if(responseBufferIndex < responseBufferLength-1)
+          {
+            // Some query commands come back as something like
+            //   +{COMMAND}:"{RESPONSE}"
+            // in which case we only want to give back the stuff between the quotes
+            if(responseBufferIndex == 0 && statusBuffer[0] == '+' && statusBuffer[1] == 'C' && *(((const char *)cmdPartsToConcatenate[0])+3) == 'C')
             {
-              // Some query commands come back as something like
-              //   +{COMMAND}:"{RESPONSE}"
-              // in which case we only want to give back the stuff between the quotes
-              if(responseBufferIndex == 0 && statusBuffer[0] == '+' && statusBuffer[1] == 'C' && *(((const char *)cmdPartsToConcatenate[0])+3) == 'C')
+              // Find length of the command
+              for(statusBufferIndex = 1; statusBuffer[statusBufferIndex]; statusBufferIndex++)
               {
-                // Find length of the command
-                for(statusBufferIndex = 1; statusBuffer[statusBufferIndex]; statusBufferIndex++)
-                {
-                  if(statusBuffer[statusBufferIndex] == ':' && statusBuffer[statusBufferIndex+1] == '"' ) 
-                  {                    
-                    break;                  
-                  }
-                }
-                
-                if(statusBuffer[statusBufferIndex]) 
-                {
-                  // Looks like we found such a pattern and the current index is going to be ':'
-                  // advance it to the character after '"' and trim off the trailing '"'
-                  statusBufferIndex += 2;
-                  
-                  if(statusBuffer[bytesRead-2] == '"' && statusBuffer[bytesRead-1] == '\r')
-                  {
-                    statusBuffer[bytesRead-2] = '\r';
-                    statusBuffer[bytesRead-1] = 0;
-                  }
-                }
-                else
-                {
-                  // Didn't find the pattern, so use the full response
-                  statusBufferIndex = 0;
+                if(statusBuffer[statusBufferIndex] == ':' && statusBuffer[statusBufferIndex+1] == '"' ) 
+                {                    
+                  break;                  
                 }
               }
               
-              memcpy(responseBuffer+responseBufferIndex, statusBuffer+statusBufferIndex, min(bytesRead-statusBufferIndex, responseBufferLength-1-responseBufferIndex));
-              responseBufferIndex += min(bytesRead-statusBufferIndex, responseBufferLength-1-responseBufferIndex);
-              
-              statusBufferIndex = 0;
-              
-              if(statusBuffer[bytesRead-1] == '\r')
+              if(statusBuffer[statusBufferIndex]) 
               {
-                if(responseBufferIndex<responseBufferLength-1)
+                // Looks like we found such a pattern and the current index is going to be ':'
+                // advance it to the character after '"' and trim off the trailing '"'
+                statusBufferIndex += 2;
+                
+                if(statusBuffer[bytesRead-2] == '"' && statusBuffer[bytesRead-1] == '\r')
                 {
-                  responseBuffer[responseBufferIndex++]='\n';
+                  statusBuffer[bytesRead-2] = '\r';
+                  statusBuffer[bytesRead-1] = 0;
                 }
               }
-            }         
-          }               
+              else
+              {
+                // Didn't find the pattern, so use the full response
+                statusBufferIndex = 0;
+              }
+            }
+            
+            memcpy(responseBuffer+responseBufferIndex, statusBuffer+statusBufferIndex, min(bytesRead-statusBufferIndex, responseBufferLength-1-responseBufferIndex));
+            responseBufferIndex += min(bytesRead-statusBufferIndex, responseBufferLength-1-responseBufferIndex);
+            
+            statusBufferIndex = 0;
+            
+            if(statusBuffer[bytesRead-1] == '\r')
+            {
+              if(responseBufferIndex<responseBufferLength-1)
+              {
+                responseBuffer[responseBufferIndex++]='\n';
+              }
+            }
+          }         
+        }               
 
-          // readBytesUntil does NOT include the terminator, conveniently as we are getting
-          // CRLF termination, we can check for the CR instead.
-          if(statusBuffer[bytesRead-1] == '\r')
-          {
-            responseLineNum++;               
-          }    
-        }
+        // readBytesUntil does NOT include the terminator, conveniently as we are getting
+        // CRLF termination, we can check for the CR instead.
+        if(statusBuffer[bytesRead-1] == '\r')
+        {
+          responseLineNum++;               
+        }    
       }
     }
-    // At 9600bps, I think we should keep this below 100uS to be able to keep up with certainty
-    delayMicroseconds(100);    
-    waitingMicroSeconds += 100;    
   }
-  while(waitingMicroSeconds < this->generalCommandTimeoutMicroseconds);    
+  while(!deadline.expired());    
   
   ESP82336_DEBUGLN("TIMED OUT");
   
@@ -1230,15 +3649,234 @@ byte ESP8266_Simple::sendCommand(const __FlashStringHelper *cmd)
   return this->sendCommand(cmdBuffer, NULL, 0);  
 }
 
+void ESP8266_Simple::listen()
+{
+  #if ESP8266_SERIALMODE != ESP8266_HARDWARESERIAL
+    this->espSerial->listen();
+  #endif
+}
+
+void ESP8266_Simple::setTracePrinter(Print *tracePrinter)
+{
+  #if ESP8266_SERIALMODE != ESP8266_HARDWARESERIAL
+    this->espSerial->setTracePrinter(tracePrinter);
+  #endif
+}
+
 void ESP8266_Simple::clearSerialBuffer()
 {
-  while(this->espSerial->available()) { this->espSerial->read();  delay(1); }
+  char lineBuffer[20];
+  
+  this->listen();
+  
+  // Acknowledgements of pipelined sends must not be thrown away with the rest
+  while(this->pendingSendChannels && this->espSerial->available())
+  {
+    memset(lineBuffer,0,sizeof(lineBuffer));
+    if(!this->espSerial->readBytesUntilAndIncluding('\n', lineBuffer, sizeof(lineBuffer)-1, 1)) break;
+    this->noteUnsolicited(lineBuffer);
+  }
+  
+#if ESP8266_ENABLE_HTTP_CLIENT
+  // Nor must the closing of a fetchAll() connection
+  while(this->fetchingChannels && this->espSerial->available())
+  {
+    memset(lineBuffer,0,sizeof(lineBuffer));
+    if(!this->espSerial->readBytesUntilAndIncluding('\n', lineBuffer, sizeof(lineBuffer)-1, 1)) break;
+    this->noteUnsolicited(lineBuffer);
+  }
+#endif
+  
+  while(this->espSerial->available()) this->espSerial->read();
   this->espSerial->overflow();
 }
 
+// Keep an eye on the response codes to commands to see if the device is in trouble
+void ESP8266_Simple::noteHealth(byte responseCode)
+{
+  if(this->recovering) return;
+  
+  switch(responseCode)
+  {
+    case ESP8266_OK:
+    case ESP8266_ERROR: // It's talking sense at least
+      this->consecutiveBusy     = 0;
+      this->consecutiveTimeouts = 0;
+      break;
+      
+    case ESP8266_BUSY:
+      if(++this->consecutiveBusy >= this->maxConsecutiveBusy)
+      {
+        this->recover(ESP8266_RECOVER_RESYNC);
+      }
+      break;
+      
+    case ESP8266_TIMEOUT:
+      if(++this->consecutiveTimeouts >= this->maxConsecutiveTimeouts)
+      {
+        this->recover(ESP8266_RECOVER_RESYNC);
+      }
+      break;
+      
+    case ESP8266_READY:
+      // If we didn't just reset it, it rebooted itself (brown out?) and has 
+      // forgotten everything we told it
+      if(millis() - this->lastResetMillis > 10000)
+      {
+        this->recoveryStats.unexpectedReboots++;
+        this->lastResetMillis = millis();
+        this->invalidateStationCache();
+        this->restoreState();
+      }
+      break;
+  }
+}
+
+byte ESP8266_Simple::recover(byte fromTier, int muxChannel)
+{
+  unsigned long startMillis = millis();
+  unsigned long recoveryMillis;
+  byte responseCode = ESP8266_ERROR;
+  byte tier;
+  
+  if(this->recovering) return ESP8266_ERROR;
+  this->recovering = 1;
+  
+  ESP82336_DEBUGLN("RECOVERING");
+  
+  for(tier = max(fromTier, ESP8266_RECOVER_CHANNEL); tier <= ESP8266_RECOVER_HARD; tier++)
+  {
+    switch(tier)
+    {
+      case ESP8266_RECOVER_CHANNEL:
+        // It doesn't matter what it says, it may well already be closed
+        this->closeConnection(muxChannel);
+        break;
+        
+      case ESP8266_RECOVER_RESYNC:
+        // Let it finish whatever it was saying and throw it away
+        this->clearSerialBuffer();
+        delay(100);
+        this->clearSerialBuffer();
+        break;
+        
+      case ESP8266_RECOVER_SOFT:
+        this->invalidateStationCache();
+        this->lastResetMillis = millis();
+        if(this->sendCommand(F("AT+RST")) != ESP8266_OK) continue;
+        this->echoState = ESP8266_ECHO_UNKNOWN;
+        break;
+        
+      case ESP8266_RECOVER_HARD:
+        if(this->resetPin < 0) continue;
+        
+        this->invalidateStationCache();
+        this->lastResetMillis = millis();
+        
+        // The RST pin has a pull up, so we pull it low and then let it go
+        // rather than drive it high (which may be 5v)
+        pinMode(this->resetPin, OUTPUT);
+        digitalWrite(this->resetPin, LOW);
+        delay(50);
+        pinMode(this->resetPin, INPUT);
+        this->echoState = ESP8266_ECHO_UNKNOWN;
+        break;
+    }
+    
+    // After a reset it takes a while to boot
+    if((responseCode = this->waitForAT(tier >= ESP8266_RECOVER_SOFT ? 10 : 2)) == ESP8266_OK) break;
+  }
+  
+  this->recovering          = 0;
+  this->consecutiveBusy     = 0;
+  this->consecutiveTimeouts = 0;
+  
+  if(responseCode != ESP8266_OK)
+  {
+    this->recoveryStats.failedRecoveries++;
+    return responseCode;
+  }
+  
+  if(tier >= ESP8266_RECOVER_SOFT)
+  {
+    this->restoreState();
+  }
+  
+  recoveryMillis = millis() - startMillis;
+  this->recoveryStats.recoveries[tier-1]++;
+  this->recoveryStats.lastTier             = tier;
+  this->recoveryStats.lastRecoveryMillis   = recoveryMillis;
+  this->recoveryStats.maxRecoveryMillis    = max(this->recoveryStats.maxRecoveryMillis, recoveryMillis);
+  this->recoveryStats.totalRecoveryMillis += recoveryMillis;
+  
+  ESP82336_DEBUGLN("RECOVERED");
+  return ESP8266_OK;
+}
+
+byte ESP8266_Simple::waitForAT(byte maxAttempts)
+{
+  byte responseCode = ESP8266_ERROR;
+  
+  while(maxAttempts--)
+  {
+    if((responseCode = this->sendCommand(F("AT"))) == ESP8266_OK) break;
+    delay(500);
+  }
+  
+  return responseCode;
+}
+
+// After the device has been reset, tell it again what it has forgotten
+byte ESP8266_Simple::restoreState()
+{
+  byte responseCode = ESP8266_OK;
+  
+#if ESP8266_ENABLE_SERVER
+  if(this->httpServerPort)
+  {
+    responseCode = this->startHttpServer(this->httpServerPort, this->httpServerRequestHandler, this->httpServerMaxBufferSize);
+  }
+#endif
+  
+  return responseCode;
+}
+
+byte ESP8266_Simple::checkHealth()
+{
+  byte responseCode = this->sendCommand(F("AT"));
+  if(responseCode == ESP8266_OK) return ESP8266_OK;
+  
+  return this->recover(ESP8266_RECOVER_RESYNC);
+}
+
+void ESP8266_Simple::setResetPin(int resetPin)
+{
+  this->resetPin = resetPin;
+}
+
+void ESP8266_Simple::setHealthThresholds(byte maxConsecutiveBusy, byte maxConsecutiveTimeouts)
+{
+  this->maxConsecutiveBusy     = maxConsecutiveBusy;
+  this->maxConsecutiveTimeouts = maxConsecutiveTimeouts;
+}
+
+void ESP8266_Simple::getRecoveryStats(ESP8266_RecoveryStats &recoveryStats)
+{
+  memcpy(&recoveryStats, &this->recoveryStats, sizeof(recoveryStats));
+}
+
+void ESP8266_Simple::clearRecoveryStats()
+{
+  memset(&this->recoveryStats, 0, sizeof(this->recoveryStats));
+}
+
 void ESP8266_Simple::getErrorMessage(byte responseCode, char *bufferWithMinLength50Char)
 {
   memset(bufferWithMinLength50Char, 0, 50);
+#if !ESP8266_ENABLE_ERROR_MESSAGES
+  strcpy_P(bufferWithMinLength50Char, PSTR("Error "));
+  itoa(responseCode, bufferWithMinLength50Char+strlen(bufferWithMinLength50Char), 10);
+#else
   switch(responseCode)
   {
     case ESP8266_ERROR:    strncpy_P(bufferWithMinLength50Char, PSTR("General Error"), 49); break;
@@ -1246,7 +3884,9 @@ void ESP8266_Simple::getErrorMessage(byte responseCode, char *bufferWithMinLengt
     case ESP8266_OVERFLOW: strncpy_P(bufferWithMinLength50Char, PSTR("Overflow In Serial Buffer"), 49); break;
     case ESP8266_BUSY:     strncpy_P(bufferWithMinLength50Char, PSTR("Device Is Busy"), 49); break;
     case ESP8266_READY:    strncpy_P(bufferWithMinLength50Char, PSTR("Device issued \"ready\" unexpectedly (rebooted)"), 49); break;
+    case ESP8266_CIRCUIT_OPEN: strncpy_P(bufferWithMinLength50Char, PSTR("Too many failures, not trying for now"), 49); break;
   }
+#endif
 }
 
 
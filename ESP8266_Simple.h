@@ -31,6 +31,7 @@
 
 #define ESP8266_SOFTWARESERIAL 1
 #define ESP8266_HARDWARESERIAL 0
+#define ESP8266_REPLAYSERIAL   2   // Play back a trace instead of talking to a device, see ESP8266_ReplaySerial
 
 #define ESP8266_OK             0
 #define ESP8266_ERROR          1
@@ -39,8 +40,44 @@
 // READY might be better set to ESP8266_OK
 #define ESP8266_READY          4
 #define ESP8266_BUSY           5
+#define ESP8266_CIRCUIT_OPEN   6   // Too many failures recently, not trying (see ESP8266_RetryPolicy)
 
-#if 0
+// Leave out what you don't use, to save flash and RAM.  Set these to 0 here,
+// or in your build flags (eg -DESP8266_ENABLE_SERVER=0) so that the library
+// is compiled with them too.  tools/footprint.py shows what each costs.
+#ifndef ESP8266_ENABLE_HTTP_CLIENT        // GET(), POST(), PUT(), sendHttpRequest()
+  #define ESP8266_ENABLE_HTTP_CLIENT 1
+#endif
+#ifndef ESP8266_ENABLE_SERVER             // startHttpServer(), serveHttpRequest() and all that goes with them
+  #define ESP8266_ENABLE_SERVER 1
+#endif
+#ifdef __AVR__
+  #include <avr/io.h>                     // FLASHEND
+#endif
+#ifndef ESP8266_ENABLE_WEBSOCKET          // Server WebSockets (needs the server)
+  #if defined(FLASHEND) && FLASHEND <= 0x7FFF
+    // With everything else an Uno (ATmega328P) has no room left, so on 32K
+    // and smaller chips set it to 1 yourself and leave something else out
+    #define ESP8266_ENABLE_WEBSOCKET 0
+  #else
+    #define ESP8266_ENABLE_WEBSOCKET ESP8266_ENABLE_SERVER
+  #endif
+#endif
+#ifndef ESP8266_ENABLE_ADAPTIVE_TIMEOUTS  // setAdaptiveTimeouts()
+  #define ESP8266_ENABLE_ADAPTIVE_TIMEOUTS 1
+#endif
+#ifndef ESP8266_ENABLE_ERROR_MESSAGES     // getErrorMessage() in words, rather than "Error n"
+  #define ESP8266_ENABLE_ERROR_MESSAGES 1
+#endif
+#ifndef ESP8266_ENABLE_DEBUG              // Debugging of the library itself, to Serial
+  #define ESP8266_ENABLE_DEBUG 0
+#endif
+
+#if ESP8266_ENABLE_WEBSOCKET && !ESP8266_ENABLE_SERVER
+  #error "ESP8266_ENABLE_WEBSOCKET needs ESP8266_ENABLE_SERVER"
+#endif
+
+#if ESP8266_ENABLE_DEBUG
 #define ESP82336_DEBUG(...)   Serial.print(__VA_ARGS__); 
 #define ESP82336_DEBUGLN(...) Serial.println(__VA_ARGS__); 
 #else
@@ -56,11 +93,89 @@
 #define ESP8266_AP      2
 #define ESP8266_BOTH    3
 
+// The firmware "dialect" is worked out once (see begin()), the AT commands
+// and responses differ between them
+#define ESP8266_DIALECT_UNKNOWN 0
+#define ESP8266_DIALECT_0924    1   // v0.9.2.4
+#define ESP8266_DIALECT_0952    2   // v0.9.5.2  (AT version 0.21, SDK 0.9.5)
+#define ESP8266_DIALECT_1X      3   // v1.x      (AT version 0.40+, SDK 1.x)
+
+// Which parts of the station cache are filled
+#define ESP8266_CACHE_IP        0x01
+#define ESP8266_CACHE_MAC       0x02
+#define ESP8266_CACHE_SSID      0x04
+#define ESP8266_CACHE_STATUS    0x08
+
+// The tiers of recover(), each is more drastic (and slower) than the last
+#define ESP8266_RECOVER_CHANNEL 1   // close the one connection (AT+CIPCLOSE)
+#define ESP8266_RECOVER_RESYNC  2   // throw away whatever is in the serial buffer and resync with AT
+#define ESP8266_RECOVER_SOFT    3   // soft reset (AT+RST)
+#define ESP8266_RECOVER_HARD    4   // hard reset by pulling the RST pin low (see setResetPin())
+
+// Each class of command has it's own timeout, see setCommandTimeout()
+#define ESP8266_COMMAND_QUICK   0   // AT, settings and queries which the ESP8266 answers itself
+#define ESP8266_COMMAND_JOIN    1   // AT+CWJAP, AT+CWLAP, which wait on the Wifi
+#define ESP8266_COMMAND_CONNECT 2   // AT+CIPSTART, which waits on the other end (and DNS)
+#define ESP8266_COMMAND_SEND    3   // AT+CIPSEND, data being sent, AT+CIPCLOSE
+#define ESP8266_COMMAND_CLASSES 4
+
+// Whether the device echoes back what we send (it does after every reset)
+#define ESP8266_ECHO_UNKNOWN    0   // Not turned off since the last reset
+#define ESP8266_ECHO_OFF        1
+#define ESP8266_ECHO_ON         2   // The firmware won't turn it off
+
+// With adaptive timeouts, a class needs this many answers before we trust
+// what we have seen, and it's timeout is never shorter than the minimum
+#define ESP8266_ADAPTIVE_MIN_SAMPLES       8
+#define ESP8266_ADAPTIVE_MIN_MICROSECONDS  20000UL
+
+// Things which only some dialects can do
+#define ESP8266_FEATURE_UDP_LOCALPORT  0x01  // AT+CIPSTART="UDP" accepts a local port
+#define ESP8266_FEATURE_SERVERMAXCONN  0x02  // AT+CIPSERVERMAXCONN limits server connections
+#define ESP8266_FEATURE_IPDINFO        0x04  // AT+CIPDINFO=1 adds the remote IP and port to +IPD
+#define ESP8266_FEATURE_SENDBUF        0x08  // AT+CIPSENDBUF queues a segment, "n,segment,SEND OK" comes later
+
+#define ESP8266_TCP     0
+#define ESP8266_UDP     1
+
 #define ESP8266_HTML    0x01000000
 #define ESP8266_TEXT    0x02000000
 #define ESP8266_RAW     0x04000000
+#define ESP8266_EVENTSTREAM 0x08000000  // Keep the connection open for pushEvent() (Server-Sent Events)
+#define ESP8266_LONGPOLL    0x10000000  // Don't answer yet, the next pushEvent() is the answer
+#define ESP8266_WEBSOCKET   0x20000000  // Upgrade the connection to a WebSocket, see setWebSocketHandler()
+#define ESP8266_CBOR        0x40000000  // application/cbor, binary so the length must be given, see ESP8266_CborWriter
+
+// A binary (ESP8266_CBOR) body can have nulls in it so the handler says how
+// long it is, packed above the status code, eg ESP8266_CBOR | ESP8266_BODY_LENGTH(n) | 200
+#define ESP8266_BODY_LENGTH(length) (((unsigned long) (length) & 0x3FFF) << 10)
+
+// The ESP8266 can have this many connections (mux channels) at once
+#define ESP8266_MUX_CHANNELS 5
+
+// With AT+CIPSENDBUF, no more than this many segments are left unacknowledged
+// on a channel before sendData() waits
+#ifndef ESP8266_SENDBUF_MAX_PENDING
+  #define ESP8266_SENDBUF_MAX_PENDING 4
+#endif
+
+// How many clients (by IP address) setRateLimit() keeps track of at once, the
+// one seen least recently is forgotten to make room for a new one
+#ifndef ESP8266_RATE_LIMIT_CLIENTS
+  #define ESP8266_RATE_LIMIT_CLIENTS 4
+#endif
+
+// Outgoing data is sent to the ESP8266 in segments of at most this many bytes 
+// (one AT+CIPSEND each), larger segments mean fewer round trips but more RAM
+// used while sending, the ESP8266 itself accepts at most 2048 per segment.
+#ifndef ESP8266_SEND_SEGMENT_SIZE
+  #define ESP8266_SEND_SEGMENT_SIZE 64
+#endif
 
 #include "ESP8266_Serial.h"
+#include "ESP8266_RetryPolicy.h"
+#include "ESP8266_WebSocket.h"
+#include "ESP8266_Cbor.h"
 
 struct ESP8266_HttpServerHandler
 {
@@ -68,6 +183,233 @@ struct ESP8266_HttpServerHandler
     unsigned long (* handlerFunction)(char *, int);
 };
 
+// A static file kept (usually gzipped) in flash with it's response headers 
+// already made, tools/make_assets.py generates a PROGMEM table of these from 
+// a directory of files, see setHttpAssets()
+struct ESP8266_HttpAsset
+{
+    const char     *requestMatches;     // eg "GET /index.html " (PROGMEM)
+    const char     *headers;            // The whole header block, status line to blank line (PROGMEM)
+    const byte     *body;               // (PROGMEM)
+    unsigned int    bodyLength;
+    const char     *etag;               // Quoted, as in the headers (PROGMEM)
+};
+
+// If-None-Match is kept if it fits in this, which our ETags do
+#ifndef ESP8266_ETAG_SIZE
+  #define ESP8266_ETAG_SIZE 12
+#endif
+
+// Something which must happen within a time, measured with micros() so it
+// is accurate however long we spend between checks, and safe when micros()
+// wraps around (so long as the length is less than about 70 minutes).
+struct ESP8266_Deadline
+{
+    unsigned long start;
+    unsigned long length;
+    
+    ESP8266_Deadline(unsigned long microseconds) : start(micros()), length(microseconds) { }
+    void          restart() { start = micros(); }
+    unsigned long elapsed() { return micros() - start; }
+    byte          expired() { return elapsed() >= length; }
+};
+
+// What recover() has had to do, and how long it took
+struct ESP8266_RecoveryStats
+{
+    unsigned int  recoveries[4];        // Incidents recovered, by tier (ESP8266_RECOVER_... - 1)
+    unsigned int  failedRecoveries;     // Incidents where even the hard reset didn't work
+    unsigned int  unexpectedReboots;    // The device said "ready" when we didn't reset it
+    byte          lastTier;             // The tier which recovered the last incident
+    unsigned long lastRecoveryMillis;   // Time to recover the last incident
+    unsigned long maxRecoveryMillis;    // The longest time to recover
+    unsigned long totalRecoveryMillis;  // Total time, divide by the sum of recoveries for the mean
+};
+
+// What the server has had to turn away, see setServerLimits() and setRateLimit()
+struct ESP8266_ServerStats
+{
+    unsigned int  shedConnections;      // Got a 503 because there were too many connections
+    unsigned int  slowConnections;      // Closed because the request didn't arrive in time
+    unsigned int  rateLimitedRequests;  // Got a 503 because that client asked too often
+};
+
+// Where the time goes for one route (one ESP8266_HttpServerHandler), the 
+// times are totals in microseconds, divide by requests for the mean
+struct ESP8266_RouteStats
+{
+    unsigned int  requests;
+    unsigned long receiveMicros;        // Reading the request from the ESP8266
+    unsigned long dispatchMicros;       // Finding the handler
+    unsigned long handlerMicros;        // Your handler
+    unsigned long sendMicros;           // AT+CIPSEND and the response
+    unsigned long closeMicros;          // AT+CIPCLOSE
+    unsigned long maxMicros;            // The slowest request, start to end
+    unsigned long responseBytes;
+};
+
+// One request which took longer than it should (see profileServer())
+struct ESP8266_SlowRequest
+{
+    int           route;                // Index of the handler, -1 for none
+    unsigned int  httpStatus;
+    unsigned int  responseBytes;
+    unsigned long receiveMicros;
+    unsigned long dispatchMicros;
+    unsigned long handlerMicros;
+    unsigned long sendMicros;
+    unsigned long closeMicros;
+    unsigned long totalMicros;
+    unsigned long startMillis;          // When it started, millis()
+};
+
+// One client being rate limited
+struct ESP8266_RateLimitClient
+{
+    unsigned long ip;
+    unsigned long windowStartMillis;
+    byte          requests;             // In this window
+};
+
+// Describes how to talk to one firmware dialect, these live in PROGMEM, as do 
+// the strings they point to
+struct ESP8266_DialectProfile
+{
+    const char *ipAddressCommand;   // Gets the station IP as +XXX:"1.2.3.4" or just 1.2.3.4
+    const char *macAddressCommand;  // Gets the station MAC as +XXX:"18:fe:34:00:00:00", NULL if unable
+    const char *closedResponse;     // What is said when a connection closes (perhaps after "n,")
+    byte        features;           // ESP8266_FEATURE_...
+};
+
+// A body writer produces the body of a POST/PUT request by print()ing it to
+// the given Print.  If no Content-Length is given for the request the writer 
+// is called twice, once to count the bytes and once to send them, so it must 
+// produce exactly the same output both times.
+typedef void (*ESP8266_BodyWriter)(Print *body, void *context);
+
+// Where to put headers of an HTTP response, each is a buffer (and it's size)
+// you provide, or NULL if you don't want it, values too long are truncated.
+struct ESP8266_HttpHeaders
+{
+    long   contentLength;       // Filled in for you, -1 if none was sent
+    long   rangeTotal;          // Filled in for you, the total from Content-Range, -1 if none (or unknown)
+    long   bodyLength;          // Filled in for you, how much of the body was read
+    char  *contentType;    byte contentTypeSize;
+    char  *etag;           byte etagSize;
+    char  *location;       byte locationSize;
+    char  *date;           byte dateSize;
+    char  *lastModified;   byte lastModifiedSize;
+    
+    ESP8266_HttpHeaders() { memset(this, 0, sizeof(ESP8266_HttpHeaders)); contentLength = rangeTotal = -1; }
+};
+
+// Describes an HTTP request more complicated than a simple GET, all strings
+// are in RAM (except method which is a PSTR()), anything not needed is left NULL.
+struct ESP8266_HttpRequest
+{
+    const char         *method;            // PSTR("POST"), PSTR("PUT") etc, NULL means GET
+    const char         *contentType;       // eg "text/csv", only sent if there is a body
+    const char         *extraHeaders;      // each line must end with \r\n
+    ESP8266_BodyWriter  bodyWriter;        // NULL for no body
+    void               *bodyWriterContext; // passed to the bodyWriter
+    long                contentLength;     // -1 to count the body with the bodyWriter first
+    ESP8266_HttpHeaders *responseHeaders;  // Response headers you want, NULL for none
+    
+    ESP8266_HttpRequest() { memset(this, 0, sizeof(ESP8266_HttpRequest)); contentLength = -1; }
+};
+
+// Given the body of a fetchAll() response a piece at a time as it arrives, it
+// must not send anything to the ESP8266 (the other responses are still coming)
+typedef void (*ESP8266_BodySink)(const char *data, int length, void *context);
+
+#define ESP8266_FETCH_STATUS  0
+#define ESP8266_FETCH_HEADERS 1
+#define ESP8266_FETCH_BODY    2
+
+// One of the requests fetchAll() makes at the same time as the others, the 
+// strings are in RAM, anything not needed is left NULL.
+struct ESP8266_HttpFetch
+{
+    unsigned long        serverIp;
+    int                  port;
+    const char          *path;
+    const char          *httpHost;             // Sent as the Host: header
+    ESP8266_HttpRequest *request;              // Method, headers, body and response headers, NULL for a plain GET
+    
+    // The body of the response goes into responseBuffer (null terminated, 
+    // truncated to fit), or if there is a bodySink to that as it arrives, 
+    // either way responseBuffer is needed to read the headers into
+    char                *responseBuffer;
+    int                  responseBufferLength;
+    ESP8266_BodySink     bodySink;
+    void                *bodySinkContext;
+    
+    // Filled in for you
+    byte                 responseCode;         // ESP8266_OK when a response came
+    int                  httpResponseCode;     // eg 200, 0 if the server didn't say
+    long                 bodyLength;           // Of the body received, including anything that didn't fit
+    
+    // fetchAll()'s own, where it is up to
+    int                  muxChannel;
+    byte                 parseState;           // ESP8266_FETCH_...
+    int                  lineLength;
+    long                 contentLength;
+    
+    ESP8266_HttpFetch() { memset(this, 0, sizeof(ESP8266_HttpFetch)); muxChannel = -1; }
+};
+
+// A Print which throws away everything, but counts how much it was given, used 
+// to find the Content-Length of a body before sending it.
+class ESP8266_CountingPrint : public Print
+{
+  public:
+    unsigned long count;
+    
+    ESP8266_CountingPrint() : count(0) { };
+    virtual size_t write(uint8_t c) { count++; return 1; };
+};
+
+// One access point found by scanAccessPoints()
+struct ESP8266_AccessPoint
+{
+    char        ssid[33];
+    byte        mac[6];
+    signed char rssi;        // Signal strength in dBm, higher (closer to 0) is stronger
+    byte        encryption;  // 0 = Open, 1 = WEP, 2 = WPA_PSK, 3 = WPA2_PSK, 4 = WPA_WPA2_PSK
+    byte        channel;
+};
+
+// Called by scanAccessPoints() for each access point as it is found
+typedef void (*ESP8266_AccessPointHandler)(ESP8266_AccessPoint *accessPoint);
+
+// Called by receiveDatagram() for each datagram (+IPD packet) received, the data is 
+// null terminated for convenience, muxChannel is -1 when not in MUX mode
+typedef void (*ESP8266_DatagramHandler)(char *data, int length, int muxChannel);
+
+class ESP8266_Simple;
+
+// A Print which collects what is written to it into a buffer and sends it 
+// over a connection with AT+CIPSEND each time the buffer fills.  Call send() 
+// when finished to send anything remaining.  If any send fails, everything 
+// after is discarded and send() returns the error.
+class ESP8266_SendBuffer : public Print
+{
+  public:
+    ESP8266_SendBuffer(ESP8266_Simple *esp, int muxChannel, char *buffer, int bufferSize);
+    
+    virtual size_t write(uint8_t c);
+    using Print::write;
+    byte           send();
+    
+  protected:
+    ESP8266_Simple *esp;
+    int             muxChannel;
+    char           *buffer;
+    int             bufferSize;
+    int             bufferIndex;
+    byte            responseCode;
+};
+
 class ESP8266_Simple
 {
   
@@ -81,6 +423,12 @@ class ESP8266_Simple
       // This isn't going to work yet, TBD
       ESP8266_Simple();      
 #endif
+
+#if ESP8266_SERIALMODE == ESP8266_REPLAYSERIAL
+      // The trace is one captured with setTracePrinter(), timeScalePercent 100 replays
+      // with the original timing, 0 as fast as possible
+      ESP8266_Simple(const char *trace, unsigned int timeScalePercent = 100);
+#endif
                   
       /**
        * Begin the ESP8266 Connection
@@ -104,6 +452,17 @@ class ESP8266_Simple
       
       byte setupAsWifiStation(const char *SSID, const char *Password, Print *debugPrinter = NULL);
       
+      /**
+       * Set how setupAsWifiStation(), reset() and startHttpServer() retry when things
+       * fail, see ESP8266_RetryPolicy.  The policy must stay around (global or static).
+       * 
+       * Without one, setupAsWifiStation() and startHttpServer() retry forever 
+       * (1 second apart, and immediately, respectively), reset() tries 5 times.
+       * 
+       * @param retryPolicy The policy, or NULL to go back to the above
+       */
+      void setRetryPolicy(ESP8266_RetryPolicy *retryPolicy);
+      
       /**
        * Perform an HTTP GET operation to get data from a server on the network (or internet).
        *  F() macro version.
@@ -124,8 +483,11 @@ class ESP8266_Simple
        * @return  ESP8266_OK, or an error code
        */
       
+#if ESP8266_ENABLE_HTTP_CLIENT
       unsigned int GET(const __FlashStringHelper *serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost = NULL, int bodyResponseOnlyFromLine = 1);
+#endif
       
+#if ESP8266_ENABLE_SERVER
       /** Start an "HTTP Server" with a number of "handlers" provided to serve various
        *   requests.
        * 
@@ -142,19 +504,91 @@ class ESP8266_Simple
        * @return ESP8266_OK, or an error code
        */
       byte startHttpServer(unsigned port, ESP8266_HttpServerHandler *httpServerHandlers, unsigned int numOfHandlers, unsigned int maxBufferSize= 250, Print *debugPrinter = NULL);
+#endif
       
-      
+#if ESP8266_ENABLE_HTTP_CLIENT
       unsigned int GET(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost = NULL, int bodyResponseOnlyFromLine = 1);
       
+      /**
+       * Perform an HTTP POST (or PUT) operation to send a body of data to a server, the
+       * body is produced by your bodyWriter function which print()s it, it is sent in 
+       * segments as it is printed so it can be much larger than your RAM.
+       * 
+       * See the HTTP_Post example for more information.
+       * 
+       * @param serverIp The IP address of the server, F("127.0.0.1") or as an unsigned long
+       * @param port     The port to connect to
+       * @param requestPathAndResponseBuffer As for GET(), the path, over-written with the response
+       * @param bufferLength The length of the buffer in bytes.
+       * @param httpHost The hostname you are connecting to (eg, F("example.com")), or NULL
+       * @param contentType The type of the body (eg, F("text/csv")), or NULL
+       * @param bodyWriter A function which prints the body to the Print it is given
+       * @param bodyWriterContext Anything you like, passed to your bodyWriter
+       * @param contentLength The length of the body if you know it, -1 to have the bodyWriter 
+       *   called an extra time to count it (it must print the same thing each time!)
+       * @param bodyResponseOnlyFromLine As for GET()
+       * 
+       * @return  The HTTP response code, or an error code
+       */
+      
+      unsigned int POST(const __FlashStringHelper *serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext = NULL, long contentLength = -1, int bodyResponseOnlyFromLine = 1);
+      unsigned int POST(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext = NULL, long contentLength = -1, int bodyResponseOnlyFromLine = 1);
+      unsigned int PUT(const __FlashStringHelper *serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext = NULL, long contentLength = -1, int bodyResponseOnlyFromLine = 1);
+      unsigned int PUT(unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext = NULL, long contentLength = -1, int bodyResponseOnlyFromLine = 1);
+#endif
+      
       
       // More General/Advanced Commands
       byte reset();      
       byte getFirmwareVersion(long &versionResponse);            // firmware version put into versionResponse
+      byte getFirmwareDialect();                                 // ESP8266_DIALECT_..., detected once
       byte setWifiMode(byte mode);                               // ESP8266_STATION, ESP8266_AP, ESP8266_BOTH
       byte getAccessPointsList(char *buffer, int bufferSize );   // puts into buffer
+      
+      /**
+       * Scan for access points, each one is parsed as it comes in from the device 
+       * so there is no limit on how many can be found.
+       * 
+       * @param accessPointHandler Called for each access point found (may be NULL)
+       * @param strongest   An array which will be filled with the strongest access points
+       *   found, strongest first, unused entries have an empty ssid (may be NULL)
+       * @param numStrongest The size of the strongest array
+       * @param onlySSID    Only scan for this SSID (faster), NULL for all
+       * @param numFound    If not NULL, set to the number of access points found
+       * 
+       * @return ESP8266_OK, or an error code
+       */
+      byte scanAccessPoints(ESP8266_AccessPointHandler accessPointHandler, ESP8266_AccessPoint *strongest = NULL, byte numStrongest = 0, const char *onlySSID = NULL, unsigned int *numFound = NULL);
       byte getIPAddress(unsigned long &ipAddress);               // ip address put into ipAddress (as 32 bits)
       byte getIPAddress(char *ipAddress);                        // ip address put into ipAddress (as 15 byte + 1 null)
-      byte setTimeout(int seconds);                              // 0-28800
+      byte getMACAddress(char *macAddress);                      // station MAC put into macAddress (as 17 byte + 1 null)
+      byte getConnectedSSID(char *ssid, int ssidBufferSize);     // SSID we are connected to (up to 32 bytes + 1 null)
+      byte getLinkStatus(byte &linkStatus);                      // AT+CIPSTATUS, 2 = Got IP, 3 = Connected, 4 = Disconnected
+      
+      // The above 4 are remembered once they have been asked of the device, until 
+      // the device tells us something changed ("WIFI DISCONNECT", "WIFI GOT IP", 
+      // "ready"...), we change it, or they are older than maxAgeMillis (0 = any age)
+      void setStationCacheMaxAge(unsigned long maxAgeMillis);
+      void invalidateStationCache(byte whichParts = 0xFF);       // ESP8266_CACHE_... OR'd together
+      byte setTimeout(int seconds);                              // For waiting on data, and ESP8266_COMMAND_QUICK
+      
+      // How long to wait for each class of command (ESP8266_COMMAND_...), 
+      // defaults are 2 seconds for QUICK and 5 for SEND and CONNECT, 20 for JOIN
+      void setCommandTimeout(byte commandClass, unsigned long milliseconds);
+      unsigned long getCommandTimeout(byte commandClass);        // In microseconds, adaptive if enabled
+      
+#if ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+      /**
+       * Learn how long each class of command normally takes (smoothed mean and
+       * deviation, as TCP does for retransmits), and time out at percent% of
+       * (mean + 4 x deviation), which is beyond nearly every normal answer, 
+       * rather than waiting for the full setCommandTimeout().  
+       * 
+       * A timeout doubles the allowance for deviation, so a slower device 
+       * soon gets more time.  0 turns it off (the default), 150 is sensible.
+       */
+      void setAdaptiveTimeouts(byte percent);
+#endif
                 
       // Station Mode, returns IPv4 address (as 4 bytes)
       long connectToWifi(const char *SSID, const char *Password);          
@@ -168,7 +602,7 @@ class ESP8266_Simple
       // Disconnect from access point
       byte disconnectFromWifi();            
       
-
+#if ESP8266_ENABLE_SERVER
       byte startHttpServer(unsigned int port, unsigned long (* requestHandler)(char *buffer, int bufferLength), unsigned int maxBufferSize = 250);
       byte stopHttpServer();
       
@@ -183,10 +617,130 @@ class ESP8266_Simple
       //   return ESP8266_TEXT | 200;
       //   return ESP8266_TEXT | 404;
       //   return ESP8266_RAW  | 200; --- RAW will mean that you have put headers into the buffer
+      //   return ESP8266_EVENTSTREAM | 200; --- text/event-stream, the connection is kept
+      //                                         open and gets every pushEvent() until
+      //                                         the client goes away, anything in the 
+      //                                         buffer is sent first (eg "retry: 5000\n\n")
+      //   return ESP8266_LONGPOLL;   --- nothing is sent now, the next pushEvent() data 
+      //                                  is sent as a text/plain response and closed
+      //   return ESP8266_WEBSOCKET;  --- accept a WebSocket upgrade, the connection is kept
+      //                                  open and frames received on it go to the
+      //                                  setWebSocketHandler() handler
+      //   return ESP8266_CBOR | ESP8266_BODY_LENGTH(n) | 200; --- application/cbor, 
+      //                              n bytes, ESP8266_CborWriter's response() does this
       //
       //  returns ESP8266_OK/ERROR
       byte serveHttpRequest();
       
+      // While in a handler, true if the request's Accept header says the client
+      // can take application/cbor (see ESP8266_CBOR)
+      byte requestAcceptsCbor();
+      
+      /**
+       * Send an event to every connection which is subscribed (see ESP8266_EVENTSTREAM
+       * and ESP8266_LONGPOLL above), connections which fail are dropped.
+       * 
+       * Note the ESP8266 closes connections which are idle for longer than the 
+       * server timeout, if you have nothing to say, pushEvent(NULL) sends a 
+       * comment to keep event streams open.
+       * 
+       * @param data      The event data (multiple lines are fine), NULL for a keep-alive
+       * @param eventName Optional event type (the "event:" field), NULL for a "message"
+       * @return The number of connections the event was sent to
+       */
+      byte pushEvent(const char *data, const char *eventName = NULL);
+      
+      // How many connections are waiting for pushEvent()
+      byte getEventSubscriberCount();
+      
+      /**
+       * Stop slow or idle clients taking all the connections, call before 
+       * startHttpServer().
+       * 
+       * @param maxConnections  At most this many clients at once (1 to 4), one
+       *                        more is let in to be told 503 and closed at once, 
+       *                        0 for no limit
+       * @param requestMillis   A client which hasn't sent it's request this long 
+       *                        after connecting is closed, 0 for no limit
+       * @param idleSeconds     The ESP8266 closes any connection nothing is sent on
+       *                        for this long (AT+CIPSTO), keep event streams busy 
+       *                        with pushEvent(NULL) if you make this short
+       * 
+       * Connections are only counted where the firmware says "n,CONNECT".
+       */
+      void setServerLimits(byte maxConnections, unsigned long requestMillis = 5000, unsigned int idleSeconds = 180);
+      
+      /**
+       * Each client (by IP address) may make maxRequests requests in windowSeconds,
+       * any more get a 503.  Only on firmware which can tell us the client's
+       * IP address (1.x), 0 maxRequests to turn it off.  Call before startHttpServer().
+       */
+      void setRateLimit(byte maxRequests, unsigned int windowSeconds);
+      
+      void getServerStats(ESP8266_ServerStats &serverStats);
+      
+      /**
+       * Time each request to the server, by route, to find out which handlers 
+       * (or if it's the talking to the ESP8266) are slow.
+       * 
+       * @param routeStats       One for each handler given to startHttpServer(),
+       *                         in the same order
+       * @param numRoutes        How many routeStats there are
+       * @param slowRequests     The most recent requests which took longer than
+       *                         slowMillis are kept here (NULL to not keep them)
+       * @param numSlowRequests  How many slowRequests there are
+       * @param slowMillis       How long is too long
+       * 
+       * Event streams are timed up to sending the headers, WebSockets and long 
+       * polls are not timed.  The arrays are cleared for you.
+       */
+      void profileServer(ESP8266_RouteStats *routeStats, byte numRoutes, ESP8266_SlowRequest *slowRequests = NULL, byte numSlowRequests = 0, unsigned long slowMillis = 500);
+      
+      // The n'th most recent slow request (0 is the latest), 0 if there isn't one
+      byte getSlowRequest(byte n, ESP8266_SlowRequest &slowRequest);
+      
+      /**
+       * Answer requests starting with statusRequest (a PSTR(), eg PSTR("GET /status")) 
+       * with the profile as text/plain, before any of the handlers, NULL to not.
+       */
+      void setServerStatusRoute(const char *statusRequest);
+      
+      /**
+       * Serve static files straight from flash, before any of the handlers.  
+       * The table (and everything in it) is in PROGMEM, as generated by 
+       * tools/make_assets.py, a request with a matching If-None-Match gets 
+       * 304 Not Modified.  NULL to stop.
+       */
+      void setHttpAssets(const ESP8266_HttpAsset *assets, byte numAssets);
+      
+#if ESP8266_ENABLE_WEBSOCKET
+      /**
+       * Set the handler for data received on WebSockets (see ESP8266_WebSocketHandler),
+       * without one serveHttpRequest() doesn't look for the WebSocket key, and
+       * so can't accept an upgrade.
+       */
+      void setWebSocketHandler(ESP8266_WebSocketHandler webSocketHandler);
+      
+      /**
+       * Send a frame on a WebSocket.
+       * 
+       * Note that this can't be done from inside the handler while the rest of 
+       * a packet is still to be read (when the client sends several frames 
+       * at once), ESP8266_BUSY is returned if you try.
+       * 
+       * @param muxChannel The WebSocket connection, -1 for all of them
+       * @param data       The payload
+       * @param length     Of the payload
+       * @param opcode     ESP8266_WS_TEXT or ESP8266_WS_BINARY
+       */
+      byte sendWebSocket(int muxChannel, const char *data, int length, byte opcode = ESP8266_WS_TEXT);
+      
+      // Close a WebSocket politely
+      byte closeWebSocket(int muxChannel);
+#endif
+#endif
+      
+#if ESP8266_ENABLE_HTTP_CLIENT
       // Issue an HTTP Get Request to some destination IP address
       // the request string, null terminated, is placed in buffer      
       // the response code from the server is returned
@@ -196,6 +750,79 @@ class ESP8266_Simple
       //
       byte sendHttpRequest(unsigned long serverIpAddress, int port, char *requestPathAndResponseBuffer, int bufferLength, char *httpHost = NULL, int bodyResponseOnlyFromLine = 1, int *httpResponseCode = NULL);
       
+      // As above, but an HTTP/1.0 request with the method, headers and body described 
+      // by request (see ESP8266_HttpRequest), the body is streamed in segments, 
+      // the response is read the same as above.
+      byte sendHttpRequest(unsigned long serverIpAddress, int port, char *requestPathAndResponseBuffer, int bufferLength, char *httpHost, ESP8266_HttpRequest *request, int bodyResponseOnlyFromLine = 1, int *httpResponseCode = NULL);
+      
+      /**
+       * Make several HTTP/1.0 requests at once, each on it's own MUX channel, so
+       * that the waits for the servers overlap and the whole lot takes about as 
+       * long as the slowest.  The responses are separated out as they arrive 
+       * into each fetch's responseBuffer (or bodySink), see ESP8266_HttpFetch.
+       * 
+       * The server's spare channels are used if it is running (so up to 5 at a 
+       * time, fewer if it has clients connected), the rest go when those are 
+       * done.  A request for the server which arrives meanwhile is lost, and 
+       * if the server is not running we are only in MUX mode until we finish,
+       * so don't have a connection of your own open.
+       * 
+       * @param maxWaitMillis For all the responses (of each lot of 5)
+       * @return ESP8266_OK if every fetch got a response, otherwise the 
+       *   responseCode of the first which didn't
+       */
+      byte fetchAll(ESP8266_HttpFetch *fetches, byte numFetches, unsigned long maxWaitMillis = 10000);
+#endif
+      
+      // Send length bytes of data over an open connection (AT+CIPSEND), muxChannel 
+      // is -1 when not in MUX mode, length must be no more than 2048, for UDP
+      // each sendData() is one datagram
+      byte sendData(int muxChannel, const char *data, int length);
+      
+      /**
+       * On firmware with AT+CIPSENDBUF (1.x), sendData() to a TCP connection 
+       * (a server connection, or one from openConnection(), in MUX mode or not)
+       * queues the segment and carries on without waiting for "SEND OK", the 
+       * acknowledgements are counted as they come in.  flushSends() waits until 
+       * they have all come (-1 when not in MUX mode), closeConnection() does 
+       * this for you.
+       * 
+       * @return ESP8266_OK, or ESP8266_ERROR if a segment failed to send
+       */
+      byte flushSends(int muxChannel);
+      
+      // Pipelined sends are on by default (when the firmware can), 0 to turn them off
+      void setPipelinedSends(byte enabled);
+      
+      // Open a connection (AT+CIPSTART), type is ESP8266_TCP or ESP8266_UDP, for UDP 
+      // a localPort may be given to receive datagrams on (firmware 0.9.5.2 and later), 
+      // muxChannel is -1 when not in MUX mode (ie, when not running a server)
+      byte openConnection(byte type, unsigned long remoteIpAddress, int remotePort, int localPort = 0, int muxChannel = -1);
+      byte closeConnection(int muxChannel = -1);
+      
+      // True once the ESP8266 has said the connection closed (-1 when not in MUX mode)
+      byte isConnectionClosed(int muxChannel = -1);
+      
+      /**
+       * Read incoming data (+IPD) yourself, a piece at a time.  First 
+       * readPacketHeader() waits for a packet and returns it's length 
+       * (0 if none came), then readPacketData() as many times as you like
+       * until it returns 0, skipPacketData() throws away the rest.
+       * 
+       * Don't send anything while part of a packet is still to be read.
+       */
+      int  readPacketHeader(int *muxChannel, unsigned long maxWaitMillis);
+      int  readPacketData(char *buffer, int length);
+      void skipPacketData();
+      
+      // To receive UDP datagrams, set a handler (and the largest datagram you want
+      // to receive, anything longer is truncated), then call receiveDatagram() as often 
+      // as possible (like serveHttpRequest()), the handler is called for each datagram.
+      //
+      // See the UDP_Telemetry example for more information.
+      void setDatagramHandler(ESP8266_DatagramHandler datagramHandler, unsigned int maxDatagramSize = 64);
+      byte receiveDatagram();
+      
       
       // Convert Dotted quad (123.123.123.123) into 32 bits
       void ipConvertDatatypeFromTo(const char *ipAddressString, unsigned long &ipAddressLong);
@@ -204,6 +831,36 @@ class ESP8266_Simple
       // IMPORTANT!  buffer must be 16 bytes long (12 bytes for digits, 3 bytes for dots, and a null termination byte)
       void ipConvertDatatypeFromTo(unsigned long ipAddressLong, char *ipAddressStringBuffer); // Make sure your ipAddressString is at least 16 bytes (null termination)
       
+      /**
+       * Try to get the device working again, starting with the least drastic 
+       * tier (ESP8266_RECOVER_...) and going to more drastic ones until it 
+       * answers "AT".  After a reset, the server (if started) is started again.
+       * 
+       * This is done for you when the device keeps saying "busy" or not
+       * answering, or a connection doesn't close properly.
+       * 
+       * @param fromTier   The first tier to try
+       * @param muxChannel The connection to close for ESP8266_RECOVER_CHANNEL (-1 when not in MUX mode)
+       * @return ESP8266_OK if it recovered, or an error code
+       */
+      byte recover(byte fromTier = ESP8266_RECOVER_RESYNC, int muxChannel = -1);
+      
+      /**
+       * Check the device answers "AT", and recover() if it doesn't, you might
+       * call this every now and then when you have nothing else to do.
+       */
+      byte checkHealth();
+      
+      // If the ESP8266 RST pin is connected to an Arduino pin (through the level shifter)
+      // recover() can do a hard reset as a last resort, -1 for not connected
+      void setResetPin(int resetPin);
+      
+      // How many "busy" or timeout responses in a row before we recover()
+      void setHealthThresholds(byte maxConsecutiveBusy, byte maxConsecutiveTimeouts);
+      
+      void getRecoveryStats(ESP8266_RecoveryStats &recoveryStats);
+      void clearRecoveryStats();
+      
       // Send command and get response into a buffer
       byte sendCommand(const char *cmd, char *responseBuffer, int responseBufferLength, byte getResponseFromLine = 1);
       byte sendCommand(const __FlashStringHelper *cmd, char *responseBuffer, int responseBufferLength, byte getResponseFromLine = 1);
@@ -221,12 +878,21 @@ class ESP8266_Simple
       
       void clearSerialBuffer();
       
+      // SoftwareSerial can only receive on one port at a time, this makes it ours, 
+      // it is done automatically before each command, and when checking for requests
+      // or datagrams, so normally you don't need to call it yourself
+      void listen();
+      
+      // Capture everything sent and received (with timing) to the given printer
+      // so it can be played back later, see ESP8266_ReplaySerial.  NULL to stop.
+      void setTracePrinter(Print *tracePrinter);
+      
       // Some help for debugging
       void getErrorMessage(byte responseCode, char *bufferWithMinLength50Char);            
       void debugPrintError(byte responseCode, Print *debugPrinter); // you can pass &Serial to debugPrinter
      
     private:
-      #if ESP8266_SERIALMODE == ESP8266_SOFTWARESERIAL
+      #if ESP8266_SERIALMODE == ESP8266_SOFTWARESERIAL || ESP8266_SERIALMODE == ESP8266_REPLAYSERIAL
       //   SoftwareSerial *espSerial;
       ESP8266_Serial *espSerial;
       #endif
@@ -236,20 +902,170 @@ class ESP8266_Simple
       #endif
           
       unsigned long generalCommandTimeoutMicroseconds;
+      ESP8266_RetryPolicy *retryPolicy;
              
     protected:
-      unsigned int readIPD(char *responseBuffer, int responseBufferLength, int bodyResponseOnlyFromLine = 1, int *parseHttpResponse = NULL, int *muxChannel = NULL);
+      unsigned int readIPD(char *responseBuffer, int responseBufferLength, int bodyResponseOnlyFromLine = 1, int *parseHttpResponse = NULL, int *muxChannel = NULL, ESP8266_HttpHeaders *responseHeaders = NULL);
+#if ESP8266_ENABLE_HTTP_CLIENT
+      void         parseHeader(const char *line, long &contentLength, ESP8266_HttpHeaders *responseHeaders);
+      void         copyHeaderValue(const char *value, char *slot, byte slotSize);
+#endif
+      byte         bodyComplete;      // readIPD() got Content-Length bytes of body
       byte         unlinkConnection();
+      int          readPacket(char *buffer, int bufferLength, int *muxChannel, unsigned long maxWaitMillis);
+      int          packetRemaining;   // Of the packet being read by readPacketData()
+      byte         waitForPrompt();
+      byte         detectDialect();
+      byte         isClosedResponse(const char *line);
       
+      byte         firmwareDialect;
+      long         firmwareVersion;
+      byte         linkClosed;        // readIPD() saw the connection close
       
+      void         initialise();
+      void         noteUnsolicited(const char *line);
+      void         noteHealth(byte responseCode);
+      byte         waitForAT(byte maxAttempts);
+      byte         restoreState();
+      byte         sendCommandParts(const char **cmdPartsToConcatenate, byte numParts, char *responseBuffer, int responseBufferLength, byte getResponseFromLine, ESP8266_Deadline &deadline);
+      byte         commandClassOf(const char *cmd);
+      byte         disableEcho();
+      byte         echoState;         // ESP8266_ECHO_...
+      unsigned long commandTimeoutMicroseconds[ESP8266_COMMAND_CLASSES];
       
+#if ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+      void          noteLatency(byte commandClass, unsigned long microseconds, byte responseCode);
+      unsigned long latencyAverage[ESP8266_COMMAND_CLASSES];    // microseconds, smoothed
+      unsigned long latencyDeviation[ESP8266_COMMAND_CLASSES];  // microseconds, smoothed
+      byte          latencySamples[ESP8266_COMMAND_CLASSES];
+      byte          adaptiveTimeoutPercent;                     // 0 for off
+#endif
+      
+      ESP8266_RecoveryStats recoveryStats;
+      int           resetPin;
+      byte          recovering;
+      byte          consecutiveBusy;
+      byte          consecutiveTimeouts;
+      byte          maxConsecutiveBusy;
+      byte          maxConsecutiveTimeouts;
+      unsigned long lastResetMillis;
+#if ESP8266_ENABLE_SERVER
+      unsigned int  httpServerPort;     // 0 if the server is not started
+#endif
+      byte         parseAccessPoint(char *line, ESP8266_AccessPoint *accessPoint);
+      byte         stationCacheIsValid(byte whichPart);
+      void         stationCacheFilled(byte whichPart);
+      
+      byte          stationCacheValid;  // ESP8266_CACHE_... 
+      unsigned long stationCacheMillis; // when the first of the valid parts was filled
+      unsigned long stationCacheMaxAgeMillis;
+      unsigned long stationIp;
+      byte          stationMac[6];
+      char          stationSsid[33];
+      byte          stationLinkStatus;
+      byte         waitForLine(const char *expectedLine);
+      
+#if ESP8266_ENABLE_HTTP_CLIENT
+      void          writeHttpRequest(Print *requestOutput, const char *path, const char *httpHost, ESP8266_HttpRequest *request);
+      byte          fetchBatch(ESP8266_HttpFetch *fetches, byte numFetches, unsigned long maxWaitMillis);
+      static void   fetchReceived(int muxChannel, const char *data, int length, void *context);
+      void          parseFetch(ESP8266_HttpFetch *fetch, const char *data, int length);
+      ESP8266_HttpFetch *fetches;         // Of the fetchBatch() under way
+      byte          numFetches;
+      byte          fetchingChannels;   // Still waiting for the rest of a response
+      
+      unsigned int sendHttpRequestWithBody(const char *method, unsigned long serverIp, int port, char *requestPathAndResponseBuffer, int bufferLength, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType, ESP8266_BodyWriter bodyWriter, void *bodyWriterContext, long contentLength, int bodyResponseOnlyFromLine);
+#endif
+      
+      byte          closedChannels;     // Said "n,CLOSED" since they were opened
+      byte          clientChannels;     // Opened by us, so not server connections
+      void          channelClosed(int muxChannel);
+      int           parseIPD(const char *fields, int &packetLength);
+      unsigned long remoteIp;           // Of the last +IPD, if CIPDINFO is on, else 0
+      byte          hasFeature(byte feature);
+      
+      // Pipelined sends (AT+CIPSENDBUF, see flushSends()), indexed by sendSlot(), 
+      // which is the mux channel, or ESP8266_MUX_CHANNELS when not in MUX mode
+      byte          pipelinedSends;
+      byte          tcpChannels;        // Opened by openConnection() as TCP, by slot
+      byte          pendingSends[ESP8266_MUX_CHANNELS+1];  // Segments not acknowledged yet
+      byte          pendingSendChannels;                   // Slots with any
+      byte          failedSendChannels;                    // Said "[n,]segment,SEND FAIL"
+      byte          sendSlot(int muxChannel);
+      byte          canPipeline(int muxChannel);
+      byte          sendData(int muxChannel, const char *header, const char *data, int length);
+      void          segmentSent(int muxChannel, byte sentOk);
+      byte          waitForSegments(int muxChannel, byte maxPending);
+      
+#if ESP8266_ENABLE_SERVER
       unsigned long (* httpServerRequestHandler)(char *, int );
       unsigned int  httpServerMaxBufferSize;
-         
+      
+      // Bitmasks of mux channels (1 << channel) subscribed to pushEvent()
+      byte          eventStreamChannels;
+      byte          longPollChannels;
+      
+      // Admission control for the server (see setServerLimits())
+      byte          serverChannels;     // Said "n,CONNECT" and not closed yet
+      byte          pendingChannels;    // Server connections with no request read yet
+      byte          shedChannels;       // Server connections to be told 503
+      unsigned long channelOpenedMillis[ESP8266_MUX_CHANNELS];
+      byte          maxServerConnections;
+      unsigned long requestDeadlineMillis;
+      unsigned int  serverIdleSeconds;
+      ESP8266_ServerStats     serverStats;
+      ESP8266_RateLimitClient rateLimitClients[ESP8266_RATE_LIMIT_CLIENTS];
+      byte          rateLimitMaxRequests;
+      unsigned int  rateLimitWindowSeconds;
+      void          channelOpened(int muxChannel);
+      void          enforceServerLimits();
+      byte          isRateLimited(unsigned long ip);
+      byte          shedConnection(int muxChannel);
+      
+      // Server profiling (see profileServer())
+      ESP8266_RouteStats  *routeStats;
+      byte                 numRoutes;
+      ESP8266_SlowRequest *slowRequests;
+      byte                 numSlowRequests;
+      byte                 nextSlowRequest;
+      unsigned long        slowRequestMicros;
+      const char          *serverStatusRoute;
+      int                  dispatchedRoute;         // Set by httpServerRequestHandler_Builtin()
+      unsigned long        dispatchedMicros;        // Time it took to find the route
+      void                 noteServerProfile(ESP8266_SlowRequest &profile);
+      byte                 serveServerStatus(int muxChannel);
+      
+#if ESP8266_ENABLE_WEBSOCKET
+      // WebSockets, only one partly received frame is kept track of, if a 
+      // packet arrives on another WebSocket before the rest of it, the first 
+      // one is closed (this is very rare with small frames)
+      ESP8266_WebSocketHandler webSocketHandler;
+      byte          webSocketChannels;
+      int           webSocketFrameChannel;
+      int           webSocketUnread;      // Bytes of the packet being deframed still to read
+      ESP8266_WebSocketChannel webSocketFrame;
+      char         *webSocketKey;         // Where readIPD() puts Sec-WebSocket-Key, when wanted
+      void          captureWebSocketKey(const char *line);
+      void          receiveWebSocket(int muxChannel, int packetLength);
+      byte          acceptWebSocket(int muxChannel, const char *webSocketKey);
+#endif
+      
+      byte          capturingRequest;     // Set while readIPD() is reading a request to serve
+      byte          acceptsCbor;
+      char         *ifNoneMatch;          // Where readIPD() puts If-None-Match, when wanted
+      void          captureRequestHeader(const char *line);
+      
+      const ESP8266_HttpAsset *httpAssets;
+      byte                     numHttpAssets;
+      byte                     serveHttpAsset(int muxChannel, const ESP8266_HttpAsset &asset, char *buffer, int bufferLength);
       
       unsigned long              httpServerRequestHandler_Builtin(char *buffer, int bufferLength);
       ESP8266_HttpServerHandler *httpServerHandlers;
       unsigned int               httpServerHandlersLength;      
+#endif
+      
+      ESP8266_DatagramHandler    datagramHandler;
+      unsigned int               datagramMaxSize;
       
 };
 
@@ -0,0 +1,270 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include "ESP8266_TelemetryQueue.h"
+
+#ifdef __AVR__
+  #include <avr/eeprom.h>
+#endif
+
+// Everything here is made of HTTP client requests
+#if ESP8266_ENABLE_HTTP_CLIENT
+
+ESP8266_TelemetryQueue::ESP8266_TelemetryQueue(ESP8266_Simple *esp, void *buffer, unsigned int bufferSize, byte recordSize, ESP8266_RecordWriter recordWriter)
+{
+  this->esp             = esp;
+  this->recordWriter    = recordWriter;
+  this->recordSize      = recordSize;
+  
+  this->ramBuffer       = (byte *)buffer;
+  this->ramCapacity     = bufferSize / recordSize;
+  this->ramHead         = 0;
+  this->ramCount        = 0;
+  
+  this->eepromAddress   = 0;
+  this->eepromCapacity  = 0;
+  this->eepromHead      = 0;
+  this->eepromCount     = 0;
+  
+  this->serverIp        = 0;
+  this->port            = 80;
+  this->path            = NULL;
+  this->httpHost        = NULL;
+  this->contentType     = NULL;
+  
+  this->maxRecords      = this->ramCapacity;
+  this->maxBytes        = 0;
+  this->maxAgeMillis    = 0;
+  this->maxBatchRecords = 0;
+  this->batchCount      = 0;
+  this->oldestMillis    = 0;
+  
+  this->minRetryDelayMillis = 1000;
+  this->maxRetryDelayMillis = 60000;
+  this->retryDelayMillis    = 0;
+  this->lastAttemptMillis   = 0;
+}
+
+void ESP8266_TelemetryQueue::setDestination(unsigned long serverIp, int port, const __FlashStringHelper *path, const __FlashStringHelper *httpHost, const __FlashStringHelper *contentType)
+{
+  this->serverIp    = serverIp;
+  this->port        = port;
+  this->path        = path;
+  this->httpHost    = httpHost;
+  this->contentType = contentType;
+}
+
+void ESP8266_TelemetryQueue::setFlushThresholds(unsigned int maxRecords, unsigned int maxBytes, unsigned long maxAgeMillis, unsigned int maxBatchRecords)
+{
+  this->maxRecords      = maxRecords;
+  this->maxBytes        = maxBytes;
+  this->maxAgeMillis    = maxAgeMillis;
+  this->maxBatchRecords = maxBatchRecords;
+}
+
+void ESP8266_TelemetryQueue::setRetryBackoff(unsigned long minDelayMillis, unsigned long maxDelayMillis)
+{
+  this->minRetryDelayMillis = minDelayMillis;
+  this->maxRetryDelayMillis = maxDelayMillis;
+}
+
+#ifdef __AVR__
+void ESP8266_TelemetryQueue::setEepromSpill(unsigned int eepromAddress, unsigned int eepromSize)
+{
+  this->eepromAddress  = eepromAddress;
+  this->eepromCapacity = eepromSize / this->recordSize;
+  this->eepromHead     = 0;
+  this->eepromCount    = 0;
+}
+#endif
+
+unsigned int ESP8266_TelemetryQueue::count()
+{
+  return this->eepromCount + this->ramCount;
+}
+
+byte ESP8266_TelemetryQueue::push(const void *record)
+{
+  byte responseCode = ESP8266_OK;
+  
+  if(!this->ramCapacity) return ESP8266_OVERFLOW;
+  
+  if(this->ramCount == this->ramCapacity)
+  {
+#ifdef __AVR__
+    // The records in EEPROM are always older than those in RAM, so the oldest
+    // in RAM goes onto the end of the EEPROM
+    if(this->eepromCapacity)
+    {
+      if(this->eepromCount == this->eepromCapacity)
+      {
+        this->eepromHead = (this->eepromHead + 1) % this->eepromCapacity;
+        this->eepromCount--;
+        responseCode = ESP8266_OVERFLOW;
+      }
+      
+      eeprom_write_block(
+        this->ramBuffer + (this->ramHead * this->recordSize), 
+        (void *)(this->eepromAddress + (((this->eepromHead + this->eepromCount) % this->eepromCapacity) * this->recordSize)), 
+        this->recordSize
+      );
+      this->eepromCount++;
+    }
+    else
+#endif
+    {
+      responseCode = ESP8266_OVERFLOW;
+    }
+    
+    this->ramHead = (this->ramHead + 1) % this->ramCapacity;
+    this->ramCount--;
+  }
+  
+  memcpy(this->ramBuffer + (((this->ramHead + this->ramCount) % this->ramCapacity) * this->recordSize), record, this->recordSize);
+  this->ramCount++;
+  
+  if(this->count() == 1)
+  {
+    this->oldestMillis = millis();
+  }
+  
+  return responseCode;
+}
+
+byte ESP8266_TelemetryQueue::poll()
+{
+  unsigned int numRecords = this->count();
+  
+  if(!numRecords) return ESP8266_OK;
+  
+  // Still waiting to try again after a failure
+  if(this->retryDelayMillis && (millis() - this->lastAttemptMillis < this->retryDelayMillis)) return ESP8266_OK;
+  
+  if( (this->maxRecords   && numRecords >= this->maxRecords)
+   || (this->maxBytes     && (unsigned long)numRecords * this->recordSize >= this->maxBytes)
+   || (this->maxAgeMillis && millis() - this->oldestMillis >= this->maxAgeMillis)
+  )
+  {
+    return this->flush();
+  }
+  
+  return ESP8266_OK;
+}
+
+byte ESP8266_TelemetryQueue::flush()
+{
+  if(!this->count()) return ESP8266_OK;
+  if(!this->path)    return ESP8266_ERROR;
+  
+  unsigned int httpResponseCode;
+  
+  // The buffer holds the path and then gets the response, we only need the
+  // response code from that so it can be small
+  char buffer[max(strlen_P((const char *)this->path)+1, 20)];
+  memset(buffer, 0, sizeof(buffer));
+  strcpy_P(buffer, (const char *)this->path);
+  
+  this->batchCount = this->count();
+  if(this->maxBatchRecords && this->batchCount > this->maxBatchRecords)
+  {
+    this->batchCount = this->maxBatchRecords;
+  }
+  
+  httpResponseCode = this->esp->POST(this->serverIp, this->port, buffer, sizeof(buffer), this->httpHost, this->contentType, ESP8266_TelemetryQueue::writeBatch, this);
+  this->lastAttemptMillis = millis();
+  
+  if(httpResponseCode >= 200 && httpResponseCode < 300)
+  {
+    this->drop(this->batchCount);
+    this->retryDelayMillis = 0;
+    
+    // The age clock is left alone after a partial batch, what is left is no 
+    // older than the oldest was, at worst it goes a bit early.  Once empty the
+    // next push() starts it again.
+    return ESP8266_OK;
+  }
+  
+  // Back off before the next try, the records stay where they are so the 
+  // order is kept
+  if(!this->retryDelayMillis)
+  {
+    this->retryDelayMillis = this->minRetryDelayMillis;
+  }
+  else
+  {
+    this->retryDelayMillis = min(this->retryDelayMillis * 2, this->maxRetryDelayMillis);
+  }
+  
+  return httpResponseCode < 100 && httpResponseCode != ESP8266_OK ? httpResponseCode : ESP8266_ERROR;
+}
+
+void ESP8266_TelemetryQueue::writeBatch(Print *body, void *context)
+{
+  ESP8266_TelemetryQueue *queue = (ESP8266_TelemetryQueue *) context;
+  byte record[queue->recordSize];
+  
+  for(unsigned int i = 0; i < queue->batchCount; i++)
+  {
+    queue->getRecord(i, record);
+    (queue->recordWriter)(body, record);
+  }
+}
+
+// Get the record index places from the start (oldest) of the queue
+void ESP8266_TelemetryQueue::getRecord(unsigned int index, void *record)
+{
+#ifdef __AVR__
+  if(index < this->eepromCount)
+  {
+    eeprom_read_block(record, (const void *)(this->eepromAddress + (((this->eepromHead + index) % this->eepromCapacity) * this->recordSize)), this->recordSize);
+    return;
+  }
+#endif
+  index -= this->eepromCount;
+  memcpy(record, this->ramBuffer + (((this->ramHead + index) % this->ramCapacity) * this->recordSize), this->recordSize);
+}
+
+// Drop numRecords from the start (oldest) of the queue
+void ESP8266_TelemetryQueue::drop(unsigned int numRecords)
+{
+  unsigned int fromEeprom = min(numRecords, this->eepromCount);
+  
+  if(fromEeprom)
+  {
+    this->eepromHead   = (this->eepromHead + fromEeprom) % this->eepromCapacity;
+    this->eepromCount -= fromEeprom;
+    numRecords        -= fromEeprom;
+  }
+  
+  numRecords = min(numRecords, this->ramCount);
+  if(numRecords)
+  {
+    this->ramHead   = (this->ramHead + numRecords) % this->ramCapacity;
+    this->ramCount -= numRecords;
+  }
+}
+
+#endif // ESP8266_ENABLE_HTTP_CLIENT
@@ -0,0 +1,155 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266TelemetryQueue_h
+#define ESP8266TelemetryQueue_h
+
+#include "ESP8266_Simple.h"
+
+// Prints one record into the body of the batch being sent, called for each
+// record in the batch (twice each, once to count the Content-Length)
+typedef void (*ESP8266_RecordWriter)(Print *body, const void *record);
+
+/** 
+ * A queue of fixed size records (eg, sensor readings) which are sent to a server
+ * in batches with a single HTTP POST, so that taking readings does not have to 
+ * wait for the network, and the network is not used for every reading.
+ * 
+ * The records are kept in a buffer you provide, when that is full the oldest
+ * records can optionally be moved into a region of EEPROM (AVR only) to make room, 
+ * when that is full too (or you don't use EEPROM) the oldest record is dropped.
+ * Note that the EEPROM is only used for extra space, the queue does not survive
+ * a reset.
+ * 
+ * See the TelemetryQueue example for more information.
+ */
+
+class ESP8266_TelemetryQueue
+{
+  public:
+    /**
+     * @param esp          The ESP8266 to send through
+     * @param buffer       Somewhere to keep the records
+     * @param bufferSize   Size of the buffer in bytes, it holds bufferSize/recordSize records
+     * @param recordSize   Size of each record in bytes
+     * @param recordWriter Function to print a record into the body of the POST
+     */
+    ESP8266_TelemetryQueue(ESP8266_Simple *esp, void *buffer, unsigned int bufferSize, byte recordSize, ESP8266_RecordWriter recordWriter);
+    
+    /** 
+     * Where to POST the batches to, the strings must be F() strings.
+     */
+    void setDestination(unsigned long serverIp, int port, const __FlashStringHelper *path, const __FlashStringHelper *httpHost = NULL, const __FlashStringHelper *contentType = NULL);
+    
+    /**
+     * When poll() should send a batch, when there are maxRecords records, or 
+     * maxBytes bytes of records, or the oldest record is maxAgeMillis old, 
+     * whichever comes first.  Any can be 0 to not be used.
+     * 
+     * No more than maxBatchRecords will be sent in one POST (0 for no limit).
+     */
+    void setFlushThresholds(unsigned int maxRecords, unsigned int maxBytes = 0, unsigned long maxAgeMillis = 0, unsigned int maxBatchRecords = 0);
+    
+    /**
+     * When sending a batch fails we wait before trying again, starting at 
+     * minDelayMillis and doubling each failure up to maxDelayMillis.
+     */
+    void setRetryBackoff(unsigned long minDelayMillis, unsigned long maxDelayMillis);
+    
+#ifdef __AVR__
+    /**
+     * Use eepromSize bytes of EEPROM from eepromAddress to hold records 
+     * when the buffer is full.  Writing EEPROM takes about 3.3mS per byte.
+     */
+    void setEepromSpill(unsigned int eepromAddress, unsigned int eepromSize);
+#endif
+    
+    /**
+     * Add a record to the end of the queue (it is copied), this never touches the
+     * network.
+     * 
+     * @return ESP8266_OK, or ESP8266_OVERFLOW if the oldest record had to be dropped
+     */
+    byte push(const void *record);
+    
+    /** 
+     * Call as often as possible from loop(), sends a batch if a threshold
+     * is reached (and we are not waiting to retry).
+     * 
+     * @return ESP8266_OK (including if nothing needed sending), or an error code
+     */
+    byte poll();
+    
+    /**
+     * Send a batch now.
+     * 
+     * @return ESP8266_OK, or an error code (ESP8266_ERROR if the server did not say 2xx)
+     */
+    byte flush();
+    
+    unsigned int count();
+    
+  protected:
+    void                 getRecord(unsigned int index, void *record);
+    void                 drop(unsigned int numRecords);
+    static void          writeBatch(Print *body, void *context);
+    
+    ESP8266_Simple      *esp;
+    ESP8266_RecordWriter recordWriter;
+    byte                 recordSize;
+    
+    byte                *ramBuffer;
+    unsigned int         ramCapacity;
+    unsigned int         ramHead;
+    unsigned int         ramCount;
+    
+    unsigned int         eepromAddress;
+    unsigned int         eepromCapacity;
+    unsigned int         eepromHead;
+    unsigned int         eepromCount;
+    
+    unsigned long        serverIp;
+    int                  port;
+    const __FlashStringHelper *path;
+    const __FlashStringHelper *httpHost;
+    const __FlashStringHelper *contentType;
+    
+    unsigned int         maxRecords;
+    unsigned int         maxBytes;
+    unsigned long        maxAgeMillis;
+    unsigned int         maxBatchRecords;
+    unsigned int         batchCount;
+    unsigned long        oldestMillis;
+    
+    unsigned long        minRetryDelayMillis;
+    unsigned long        maxRetryDelayMillis;
+    unsigned long        retryDelayMillis;
+    unsigned long        lastAttemptMillis;
+};
+
+#endif
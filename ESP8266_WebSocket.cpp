@@ -0,0 +1,121 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include "ESP8266_WebSocket.h"
+
+#define ESP8266_SHA1_ROTL(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
+
+ESP8266_Sha1::ESP8266_Sha1()
+{
+  this->state[0]   = 0x67452301;
+  this->state[1]   = 0xEFCDAB89;
+  this->state[2]   = 0x98BADCFE;
+  this->state[3]   = 0x10325476;
+  this->state[4]   = 0xC3D2E1F0;
+  this->blockIndex = 0;
+  this->length     = 0;
+}
+
+size_t ESP8266_Sha1::write(uint8_t c)
+{
+  this->block[this->blockIndex++] = c;
+  this->length++;
+  
+  if(this->blockIndex == sizeof(this->block))
+  {
+    this->processBlock();
+  }
+  
+  return 1;
+}
+
+void ESP8266_Sha1::processBlock()
+{
+  uint32_t w[16];
+  uint32_t a = this->state[0];
+  uint32_t b = this->state[1];
+  uint32_t c = this->state[2];
+  uint32_t d = this->state[3];
+  uint32_t e = this->state[4];
+  uint32_t f;
+  uint32_t k;
+  uint32_t temp;
+  byte     i;
+  
+  for(i = 0; i < 16; i++)
+  {
+    w[i] = ((uint32_t) this->block[i*4] << 24) | ((uint32_t) this->block[i*4+1] << 16) | ((uint32_t) this->block[i*4+2] << 8) | this->block[i*4+3];
+  }
+  
+  for(i = 0; i < 80; i++)
+  {
+    // Only the last 16 words of the schedule are ever needed
+    if(i >= 16)
+    {
+      temp = w[(i+13) & 15] ^ w[(i+8) & 15] ^ w[(i+2) & 15] ^ w[i & 15];
+      w[i & 15] = ESP8266_SHA1_ROTL(temp, 1);
+    }
+    
+    if(i < 20)      { f = (b & c) | (~b & d);           k = 0x5A827999; }
+    else if(i < 40) { f = b ^ c ^ d;                    k = 0x6ED9EBA1; }
+    else if(i < 60) { f = (b & c) | (b & d) | (c & d);  k = 0x8F1BBCDC; }
+    else            { f = b ^ c ^ d;                    k = 0xCA62C1D6; }
+    
+    temp = ESP8266_SHA1_ROTL(a, 5) + f + e + k + w[i & 15];
+    e = d;
+    d = c;
+    c = ESP8266_SHA1_ROTL(b, 30);
+    b = a;
+    a = temp;
+  }
+  
+  this->state[0] += a;
+  this->state[1] += b;
+  this->state[2] += c;
+  this->state[3] += d;
+  this->state[4] += e;
+  
+  this->blockIndex = 0;
+}
+
+void ESP8266_Sha1::result(byte *hash)
+{
+  unsigned long bitLength = this->length * 8;
+  byte i;
+  
+  // Pad with 0x80 then zeros, leaving 8 bytes at the end of the block for the length
+  this->write(0x80);
+  while(this->blockIndex != 56) this->write((uint8_t) 0);
+  
+  // We never hash more than 4GB, so the top 4 bytes of the length are always zero
+  for(i = 0; i < 4; i++) this->write((uint8_t) 0);
+  for(i = 0; i < 4; i++) this->write((bitLength >> (24 - i*8)) & 0xFF);
+  
+  for(i = 0; i < 20; i++)
+  {
+    hash[i] = (this->state[i/4] >> (24 - (i%4)*8)) & 0xFF;
+  }
+}
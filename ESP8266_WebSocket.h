@@ -0,0 +1,96 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+// Please note, the Arduino IDE is a bit retarded, if the below define has an
+// underscore other than _h, it goes mental.  Wish it wouldn't  mess
+// wif ma files!
+#ifndef ESP8266WebSocket_h
+#define ESP8266WebSocket_h
+
+#include <Arduino.h>
+
+// WebSocket frame opcodes
+#define ESP8266_WS_CONTINUATION 0x0
+#define ESP8266_WS_TEXT         0x1
+#define ESP8266_WS_BINARY       0x2
+#define ESP8266_WS_CLOSE        0x8
+#define ESP8266_WS_PING         0x9
+#define ESP8266_WS_PONG         0xA
+
+// Received frame payloads are handed over in pieces of at most this many bytes
+#ifndef ESP8266_WEBSOCKET_CHUNK_SIZE
+  #define ESP8266_WEBSOCKET_CHUNK_SIZE 32
+#endif
+
+/**
+ * Called by serveHttpRequest() for data received on a WebSocket, a frame
+ * which is bigger than ESP8266_WEBSOCKET_CHUNK_SIZE, or which arrives in 
+ * more than one packet, is given in more than one piece, final is set on 
+ * the last piece of a frame.
+ * 
+ * opcode is ESP8266_WS_TEXT or ESP8266_WS_BINARY (ESP8266_WS_CONTINUATION for
+ * following frames of a fragmented message), or ESP8266_WS_CLOSE when the 
+ * other end closes it (the connection is closed for you).
+ */
+typedef void (*ESP8266_WebSocketHandler)(int muxChannel, byte opcode, char *data, int length, byte final);
+
+// Where we are up to deframing on one channel, frames can be split across 
+// +IPD packets so this has to be kept between them
+struct ESP8266_WebSocketChannel
+{
+    byte          headerIndex;       // How many bytes of the frame header we have so far
+    byte          headerLength;      // How many there will be (2 + extended length + mask)
+    byte          opcode;            // Including the FIN bit (0x80)
+    byte          mask[4];
+    unsigned int  payloadLength;
+    unsigned int  payloadIndex;
+};
+
+/**
+ * A compact SHA-1 for the WebSocket handshake, print() what is to be
+ * hashed to it then get the result.  Uses a rolling message schedule so it
+ * needs only about 100 bytes of RAM.
+ */
+class ESP8266_Sha1 : public Print
+{
+  public:
+    ESP8266_Sha1();
+    
+    virtual size_t write(uint8_t c);
+    using Print::write;
+    
+    // Get the 20 byte hash, after this the object must not be written to again
+    void result(byte *hash);
+    
+  protected:
+    void          processBlock();
+    
+    uint32_t      state[5];
+    byte          block[64];
+    byte          blockIndex;
+    unsigned long length;
+};
+
+#endif
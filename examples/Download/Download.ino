@@ -0,0 +1,111 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <EEPROM.h>
+#include <ESP8266_Simple.h>
+#include <ESP8266_Download.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect up your ESP8266
+ESP8266_Simple wifi(8,9);
+
+// The table is stored in EEPROM from address 16, the first 8 bytes of EEPROM
+// remember how far we got (so a reset doesn't mean starting again).
+unsigned int tableAddress = 16;
+
+struct Progress
+{
+  unsigned long offset;
+  uint32_t      crc;
+};
+
+// Each piece is stored in EEPROM by the eepromSink which comes with 
+// ESP8266_Download, you could write your own sink to store on an SD card 
+// or external flash instead.
+ESP8266_Download download(&wifi, ESP8266_Download::eepromSink, &tableAddress);
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo Download Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  unsigned long serverIp;
+  wifi.ipConvertDatatypeFromTo("54.241.37.107", serverIp);  
+  download.setSource(serverIp, 80, F("/esp8266-table.bin"), F("sparks.gogo.co.nz"));
+  
+  // Carry on from where we got to before (a blank EEPROM reads 0xFF, 
+  // which means start again)
+  Progress progress;
+  EEPROM.get(0, progress);
+  if(progress.offset != 0xFFFFFFFFUL)
+  {
+    download.resume(progress.offset, progress.crc);
+  }
+  
+  // A blank line just for debug formatting 
+  Serial.println();
+}
+
+void loop()
+{
+  // Each piece is as big as the buffer (less the room needed for headers 
+  // to go past), a bigger buffer means fewer requests.
+  char buffer[160];
+  
+  while(!download.finished())
+  {
+    if(download.step(buffer, sizeof(buffer)) != ESP8266_OK)
+    {
+      Serial.println(F("Piece failed, trying again shortly"));
+      delay(2000);
+      continue;
+    }
+    
+    // Remember what we have, if it gets reset now we carry on from here
+    Progress progress;
+    progress.offset = download.getOffset();
+    progress.crc    = download.getCrc();
+    EEPROM.put(0, progress);
+    
+    Serial.print(download.getOffset());
+    Serial.print(F(" of "));
+    Serial.println(download.getLength());
+  }
+  
+  Serial.print(F("Finished, CRC-32 is "));
+  Serial.println(download.getCrc(), HEX);
+  
+  while(1);
+}
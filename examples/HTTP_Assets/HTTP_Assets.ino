@@ -0,0 +1,105 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+
+// The web page and style sheet in the data folder, gzipped, made with
+//   python3 tools/make_assets.py examples/HTTP_Assets/data examples/HTTP_Assets/web_assets.h
+// run that again whenever you change them.
+#include "web_assets.h"
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect up your ESP8266
+ESP8266_Simple wifi(8,9);
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo Server Assets Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  // The handlers are only for what isn't one of the files
+  static ESP8266_HttpServerHandler myServerHandlers[] = {
+    { PSTR("GET /millis"), httpMillis },    
+    { PSTR("GET /led"),    httpLed    },
+    { PSTR("GET "),        http404    } 
+  };
+  
+  // Serve the files straight from flash (before the handlers get a look), 
+  // they are sent gzipped and your browser unzips them.  When the browser 
+  // already has a file it gets told "304 Not Modified" instead.
+  wifi.setHttpAssets(webAssets, WEBASSETS_COUNT);
+  
+  // The files are sent a buffer (120 bytes here) at a time, so they can
+  // be much bigger than the buffer.
+  wifi.startHttpServer(80, myServerHandlers, sizeof(myServerHandlers), 120, &Serial);
+  Serial.println("( Now you can use your web browser to hit the IP address above. )");
+  
+  // A blank line just for debug formatting 
+  Serial.println();
+}
+
+void loop()
+{        
+  wifi.serveHttpRequest(); 
+}
+
+// The page asks for this to show the millis()
+unsigned long httpMillis(char *buffer, int bufferLength)
+{
+  memset(buffer,0,bufferLength);
+  ultoa(millis(),buffer,10);
+  return ESP8266_TEXT | 200;  
+}
+
+// Toggle the LED on pin D13
+unsigned long httpLed(char *buffer, int bufferLength)
+{  
+  static byte ledStatus = 0;
+  
+  ledStatus = !ledStatus;
+  pinMode(13, OUTPUT);
+  digitalWrite(13, ledStatus ? HIGH : LOW);
+  
+  memset(buffer,0,bufferLength);
+  strncpy_P(buffer, ledStatus ? PSTR("<p>The D13 LED is ON, <a href=\"/\">back</a></p>") : PSTR("<p>The D13 LED is OFF, <a href=\"/\">back</a></p>"), bufferLength-1);
+  return ESP8266_HTML | 200;
+}
+
+unsigned long http404(char *buffer, int bufferLength)
+{  
+  memset(buffer, 0, bufferLength);  
+  strncpy_P(buffer, PSTR("<h1>Not Found</h1><p>Try <a href=\"/\">/</a></p>"), bufferLength-1);
+  return ESP8266_HTML | 404;
+}
@@ -0,0 +1,72 @@
+// Generated by tools/make_assets.py from data, do not edit
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <ESP8266_Simple.h>
+
+// /index.html, 444 bytes (712 before gzip)
+static const char webAssets_index_html_request0[] PROGMEM = "GET /index.html ";
+static const char webAssets_index_html_request1[] PROGMEM = "GET / ";
+static const char webAssets_index_html_headers[] PROGMEM = "HTTP/1.0 200 OK\r\nContent-Type: text/html\r\nContent-Encoding: gzip\r\nContent-Length: 444\r\nETag: \"b7431311\"\r\nCache-Control: no-cache\r\n\r\n";
+static const char webAssets_index_html_etag[] PROGMEM = "\"b7431311\"";
+static const byte webAssets_index_html_body[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x6d, 0x52, 0xc1, 0x6e, 0xd4, 0x30,
+  0x10, 0xbd, 0xf7, 0x2b, 0x86, 0x5c, 0xb2, 0x2b, 0xed, 0x26, 0x2a, 0x87, 0xaa, 0x52, 0x9d, 0x48,
+  0xd0, 0x46, 0x80, 0x54, 0x44, 0x45, 0x73, 0x80, 0xa3, 0x1b, 0x4f, 0x62, 0x0b, 0xc7, 0x36, 0xf6,
+  0x64, 0x97, 0x05, 0xf1, 0xef, 0x38, 0x71, 0x53, 0x68, 0xc5, 0xc9, 0xe3, 0x37, 0x6f, 0xde, 0xbc,
+  0x19, 0x9b, 0xbd, 0xba, 0xf9, 0x74, 0xdd, 0x7e, 0xbd, 0x6b, 0x40, 0xd2, 0xa8, 0xeb, 0x33, 0xb6,
+  0x1e, 0xc8, 0x45, 0x7d, 0x06, 0xc0, 0x46, 0x24, 0x0e, 0x9d, 0xe4, 0x3e, 0x20, 0x55, 0xd9, 0x44,
+  0xfd, 0xfe, 0x32, 0xfb, 0x9b, 0x30, 0x7c, 0xc4, 0x2a, 0x3b, 0x28, 0x3c, 0x3a, 0xeb, 0x29, 0x83,
+  0xce, 0x1a, 0x42, 0x13, 0x89, 0x47, 0x25, 0x48, 0x56, 0x02, 0x0f, 0xaa, 0xc3, 0xfd, 0x72, 0xd9,
+  0x81, 0x32, 0x8a, 0x14, 0xd7, 0xfb, 0xd0, 0x71, 0x8d, 0xd5, 0x79, 0x92, 0x21, 0x45, 0x1a, 0xeb,
+  0xe6, 0xfe, 0xee, 0xf2, 0xf5, 0xc5, 0x05, 0xdc, 0x23, 0x91, 0x32, 0x43, 0x60, 0x65, 0xc2, 0x67,
+  0x86, 0x56, 0xe6, 0x1b, 0x78, 0xd4, 0x55, 0x16, 0xe8, 0xa4, 0x31, 0x48, 0xc4, 0xd8, 0x49, 0x7a,
+  0xec, 0xab, 0xac, 0x5c, 0xa0, 0xa2, 0x0b, 0x21, 0xaa, 0xb1, 0x32, 0xb9, 0x66, 0x0f, 0x56, 0x9c,
+  0x96, 0x52, 0x79, 0xfe, 0x1f, 0xe5, 0x08, 0xce, 0x39, 0x57, 0xb7, 0x52, 0x05, 0x70, 0x7c, 0xc0,
+  0x1d, 0x70, 0x23, 0x80, 0x24, 0xc2, 0x22, 0x07, 0x4b, 0x8b, 0x08, 0xfa, 0x18, 0xa2, 0x3f, 0xa0,
+  0x80, 0xe1, 0xa7, 0x72, 0x2e, 0x9e, 0x81, 0x3c, 0x57, 0x83, 0x24, 0xe8, 0xbd, 0x1d, 0x97, 0x8a,
+  0x37, 0x5e, 0x4c, 0xca, 0xd8, 0x3c, 0x40, 0xaf, 0x79, 0x90, 0x05, 0x2b, 0xdd, 0x93, 0xfc, 0x53,
+  0x16, 0x24, 0x0f, 0xf0, 0x80, 0x68, 0xc0, 0x4f, 0xc6, 0x44, 0x1b, 0xd0, 0x5b, 0x0f, 0x2c, 0x38,
+  0x6e, 0x40, 0x89, 0x2a, 0x1b, 0x95, 0xd6, 0x2a, 0x8e, 0x50, 0x14, 0xb1, 0x7e, 0x46, 0x6b, 0x48,
+  0x10, 0xc6, 0x85, 0x8a, 0xf0, 0x8f, 0x28, 0xe3, 0xeb, 0xe4, 0x1a, 0x45, 0x56, 0xb7, 0x76, 0x18,
+  0xa2, 0xe1, 0xd9, 0xc8, 0x6d, 0x73, 0xc3, 0x4a, 0x5e, 0xaf, 0xd4, 0xd0, 0x79, 0xe5, 0x68, 0x0e,
+  0x01, 0x0e, 0xdc, 0xc7, 0x05, 0x7e, 0x9f, 0x30, 0x10, 0x54, 0x60, 0xf0, 0x08, 0x5f, 0x3e, 0xde,
+  0xbe, 0x27, 0x72, 0x9f, 0x13, 0xb8, 0xd9, 0x5e, 0x2d, 0xbc, 0x47, 0x4e, 0x61, 0x8d, 0xb6, 0x5c,
+  0x44, 0x6a, 0x3f, 0x99, 0x8e, 0x94, 0x35, 0x9b, 0x2d, 0xfc, 0x02, 0x61, 0xbb, 0x69, 0x8c, 0x8f,
+  0x5b, 0x0c, 0x48, 0x8d, 0xc6, 0x39, 0x7c, 0x7b, 0xfa, 0x20, 0x36, 0x79, 0xb2, 0x9a, 0x6f, 0x0b,
+  0xc2, 0x1f, 0x74, 0x9d, 0x7e, 0x40, 0x2c, 0x5e, 0xd5, 0x3c, 0x06, 0x67, 0x4d, 0xc0, 0x36, 0x66,
+  0xaf, 0xe0, 0xf7, 0x8b, 0x56, 0x0e, 0xcd, 0x26, 0x7f, 0xd7, 0xb4, 0xf9, 0x0e, 0xf2, 0x72, 0x55,
+  0x7a, 0xce, 0x09, 0x68, 0x44, 0xb2, 0x18, 0x97, 0xf3, 0x38, 0x16, 0x2b, 0xd3, 0x23, 0xc7, 0xe7,
+  0x5c, 0x3e, 0xec, 0x1f, 0x11, 0x13, 0x43, 0xb7, 0xc8, 0x02, 0x00, 0x00,
+};
+
+// /style.css, 224 bytes (355 before gzip)
+static const char webAssets_style_css_request0[] PROGMEM = "GET /style.css ";
+static const char webAssets_style_css_headers[] PROGMEM = "HTTP/1.0 200 OK\r\nContent-Type: text/css\r\nContent-Encoding: gzip\r\nContent-Length: 224\r\nETag: \"4fc7b2d9\"\r\nCache-Control: no-cache\r\n\r\n";
+static const char webAssets_style_css_etag[] PROGMEM = "\"4fc7b2d9\"";
+static const byte webAssets_style_css_body[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x75, 0x90, 0x49, 0x6e, 0xc3, 0x30,
+  0x0c, 0x45, 0xf7, 0x3a, 0x05, 0x81, 0xac, 0x15, 0xc4, 0x31, 0x9a, 0x85, 0x72, 0x1a, 0x6a, 0x72,
+  0x88, 0x48, 0xa2, 0x21, 0xc9, 0xa8, 0xd3, 0x22, 0x77, 0xaf, 0x25, 0xa3, 0x68, 0x53, 0xa0, 0x9f,
+  0xbb, 0xcf, 0xe9, 0x91, 0x9a, 0xed, 0x43, 0x7c, 0x0a, 0x00, 0xcf, 0xa9, 0x4a, 0x8f, 0x91, 0xc2,
+  0x43, 0x41, 0xc1, 0x54, 0x64, 0x71, 0x99, 0xfc, 0x75, 0x4b, 0x45, 0x5c, 0xe5, 0x3b, 0xd9, 0x7a,
+  0x53, 0x30, 0x9e, 0x5c, 0xdc, 0xad, 0x3c, 0x51, 0x52, 0x70, 0x76, 0x11, 0x70, 0xa9, 0xdc, 0xbc,
+  0x19, 0xad, 0xa5, 0x34, 0x29, 0x38, 0xc1, 0xb0, 0x57, 0x19, 0x0e, 0x9c, 0x15, 0x1c, 0xc6, 0xae,
+  0xe6, 0x68, 0x34, 0xf7, 0x29, 0xf3, 0x92, 0xac, 0xfc, 0x4e, 0x7a, 0x6c, 0x71, 0x15, 0x4f, 0x21,
+  0x6e, 0xc3, 0x0f, 0x4a, 0xa1, 0x0f, 0xa7, 0x60, 0x38, 0xbe, 0xed, 0xa3, 0x34, 0x67, 0xeb, 0xb2,
+  0xd4, 0x5c, 0x2b, 0xc7, 0xcd, 0x9f, 0x57, 0x28, 0x1c, 0xc8, 0xc2, 0xc1, 0x74, 0xf5, 0x7e, 0xec,
+  0xed, 0x96, 0xca, 0x1c, 0x70, 0xbb, 0x82, 0x52, 0xa0, 0xe4, 0xa4, 0x0e, 0x6c, 0xee, 0xaf, 0x80,
+  0x6d, 0xea, 0x5f, 0x48, 0xdf, 0xf5, 0x0f, 0xe4, 0x38, 0x5e, 0x2e, 0x6d, 0x09, 0x40, 0x75, 0x6b,
+  0x95, 0xd6, 0x19, 0xce, 0x58, 0x89, 0xb7, 0x17, 0x24, 0x4e, 0xee, 0x17, 0x61, 0x46, 0x4b, 0x4b,
+  0x69, 0x3b, 0xce, 0x1d, 0xfd, 0x29, 0xbe, 0x00, 0xd9, 0xb2, 0xc7, 0x4f, 0x63, 0x01, 0x00, 0x00,
+};
+
+static const ESP8266_HttpAsset webAssets[] PROGMEM = {
+  { webAssets_index_html_request0, webAssets_index_html_headers, webAssets_index_html_body, sizeof(webAssets_index_html_body), webAssets_index_html_etag },
+  { webAssets_index_html_request1, webAssets_index_html_headers, webAssets_index_html_body, sizeof(webAssets_index_html_body), webAssets_index_html_etag },
+  { webAssets_style_css_request0, webAssets_style_css_headers, webAssets_style_css_body, sizeof(webAssets_style_css_body), webAssets_style_css_etag },
+};
+
+#define WEBASSETS_COUNT (sizeof(webAssets) / sizeof(webAssets[0]))
+
+#endif
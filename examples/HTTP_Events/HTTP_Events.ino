@@ -0,0 +1,98 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect the ESP8266
+ESP8266_Simple wifi(8,9);
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("ESP8266 Demo Event Server Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  // /events is a stream of Server-Sent Events, in a browser
+  //   new EventSource("/events").onmessage = function(e) { ... e.data ... };
+  //
+  // /next waits for the next reading, for things which can't do EventSource
+  static ESP8266_HttpServerHandler myServerHandlers[] = {
+    { PSTR("GET /events"), httpEvents },    
+    { PSTR("GET /next"),   httpNext   },
+    { PSTR("GET "),        http404    } 
+  };
+  
+  wifi.startHttpServer(80, myServerHandlers, sizeof(myServerHandlers), 100, &Serial);
+  Serial.println();
+}
+
+void loop()
+{        
+  static unsigned long lastReading = 0;
+  char reading[12];
+  
+  wifi.serveHttpRequest(); 
+  
+  // Every second push a reading to everybody listening, there's no need to 
+  // check if anybody is, pushEvent() does nothing if not
+  if(millis() - lastReading > 1000)
+  {
+    lastReading = millis();
+    itoa(analogRead(A0), reading, 10);
+    wifi.pushEvent(reading);
+  }
+}
+
+// Subscribe to the events, anything put in the buffer is sent first, here
+// we tell the browser to reconnect after 5 seconds if we go away
+unsigned long httpEvents(char *buffer, int bufferLength)
+{
+  memset(buffer, 0, bufferLength);
+  strncpy_P(buffer, PSTR("retry: 5000\n\n"), bufferLength-1);
+  return ESP8266_EVENTSTREAM | 200;
+}
+
+// Don't answer now, the next pushEvent() will
+unsigned long httpNext(char *buffer, int bufferLength)
+{
+  return ESP8266_LONGPOLL;
+}
+
+unsigned long http404(char *buffer, int bufferLength)
+{  
+  memset(buffer, 0, bufferLength);  
+  strcpy_P(buffer, PSTR("Try /events or /next"));
+  return ESP8266_TEXT | 404;
+}
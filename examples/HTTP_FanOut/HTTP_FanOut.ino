@@ -0,0 +1,139 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect up your ESP8266
+ESP8266_Simple wifi(8,9);
+
+// Each time around we ask three things of the server at once, rather than
+// one after the other, so it takes about as long as the slowest of them.
+#define NUM_FETCHES 3
+
+ESP8266_HttpFetch fetches[NUM_FETCHES];
+
+// Somewhere for each response to go, the first two are small
+char timeBuffer[40];
+char counterBuffer[40];
+
+// The last could be long, so rather than keep it we just count the lines
+// as it arrives.  A sink must not use the wifi, the other responses are 
+// still coming in while it is called.
+unsigned int lines;
+char         lineBuffer[40];  // Only used for the headers
+
+void countLines(const char *data, int length, void *context)
+{
+  for(int i = 0; i < length; i++)
+  {
+    if(data[i] == '\n') lines++;
+  }
+}
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo Fan Out Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  unsigned long serverIp;
+  wifi.ipConvertDatatypeFromTo("54.241.37.107", serverIp);
+  
+  // These could just as well be three different servers
+  for(byte i = 0; i < NUM_FETCHES; i++)
+  {
+    fetches[i].serverIp = serverIp;
+    fetches[i].port     = 80;
+    fetches[i].httpHost = "sparks.gogo.co.nz";
+  }
+  
+  fetches[0].path                 = "/esp8266-time.php";
+  fetches[0].responseBuffer       = timeBuffer;
+  fetches[0].responseBufferLength = sizeof(timeBuffer);
+  
+  fetches[1].path                 = "/esp8266-counter.php";
+  fetches[1].responseBuffer       = counterBuffer;
+  fetches[1].responseBufferLength = sizeof(counterBuffer);
+  
+  fetches[2].path                 = "/esp8266-readme.txt";
+  fetches[2].responseBuffer       = lineBuffer;
+  fetches[2].responseBufferLength = sizeof(lineBuffer);
+  fetches[2].bodySink             = countLines;
+  
+  // A blank line just for debug formatting 
+  Serial.println();
+}
+
+void loop()
+{
+  unsigned long startMillis = millis();
+  
+  lines = 0;
+  wifi.fetchAll(fetches, NUM_FETCHES);
+  
+  Serial.print("All done in ");
+  Serial.print(millis() - startMillis);
+  Serial.println("mS");
+  
+  for(byte i = 0; i < NUM_FETCHES; i++)
+  {
+    Serial.print(fetches[i].path);
+    Serial.print(": ");
+    
+    if(fetches[i].responseCode != ESP8266_OK)
+    {
+      // No response, getErrorMessage() will tell you why
+      char errorMessage[50];
+      wifi.getErrorMessage(fetches[i].responseCode, errorMessage);
+      Serial.println(errorMessage);
+      continue;
+    }
+    
+    Serial.print(fetches[i].httpResponseCode);
+    Serial.print(' ');
+    if(fetches[i].bodySink)
+    {
+      Serial.print(lines);
+      Serial.println(" lines");
+    }
+    else
+    {
+      Serial.println(fetches[i].responseBuffer);
+    }
+  }
+  
+  Serial.println();
+  delay(10000);
+}
@@ -0,0 +1,121 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect up your ESP8266
+ESP8266_Simple wifi(8,9);
+
+// We will collect a reading every second, and send them all to the 
+// server in one POST every 100 readings, which is MUCH faster than doing 
+// a GET for each one.
+#define NUM_READINGS 100
+
+int          readings[NUM_READINGS];
+unsigned int numReadings = 0;
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo POST Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  // A blank line just for debug formatting 
+  Serial.println();
+}
+
+// This is our body writer, it is given a Print to print the body 
+// of the request to, just like you would print to Serial.  
+//
+// Because we don't tell POST() how long the body is going to be, this
+// will be called twice, once to count how long it is, and then again 
+// to actually send it, so it must print exactly the same thing both times.
+//
+// The context is whatever you passed to POST(), we don't need it here.
+
+void writeReadings(Print *body, void *context)
+{
+  for(unsigned int i = 0; i < numReadings; i++)
+  {
+    body->println(readings[i]);
+  }
+}
+
+void loop()
+{
+  readings[numReadings++] = analogRead(A0);
+  
+  if(numReadings == NUM_READINGS)
+  {
+    // The buffer holds the path to POST to, and is over-written with the 
+    // response, just like GET()
+    char buffer[50]; 
+    memset(buffer, 0, sizeof(buffer));
+    strncpy_P(buffer, PSTR("/esp8266-readings.php"), sizeof(buffer)-1);
+    
+    Serial.print("Posting ");
+    Serial.print(numReadings);
+    Serial.print(" readings: ");
+    
+    unsigned int httpResponseCode = 
+      wifi.POST
+      (
+        F("54.241.37.107"),     // The IP address of the server you want to contact
+        80,                     // The Port to Connect to (80 is the usual "http" port)
+        buffer,                 // Your buffer which currently contains the path to post to
+        sizeof(buffer),         // The size of the buffer
+        F("sparks.gogo.co.nz"), // The hostname you are connecting to
+        F("text/plain"),        // The type of data you are sending
+        writeReadings           // The function which will print the body
+      );
+    
+    if(httpResponseCode == 200)
+    {
+      Serial.println("OK");
+      numReadings = 0;
+    }
+    else
+    {
+      // If it didn't work, we will just try again after the next reading
+      // (throwing away the oldest reading to make room)
+      Serial.print("Error ");
+      Serial.println(httpResponseCode);
+      memmove(readings, readings+1, sizeof(readings)-sizeof(readings[0]));
+      numReadings--;
+    }
+  }
+  
+  delay(1000);
+}
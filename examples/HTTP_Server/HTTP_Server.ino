@@ -97,6 +97,20 @@ void setup()
     { PSTR("GET "),        http404    } 
   };
   
+  // Don't let any more than 3 clients connect at once (any more are told 
+  // "503 Service Unavailable"), and close any which haven't sent their 
+  // request within 5 seconds, so that one slow or misbehaving client can't
+  // take all the connections.
+  wifi.setServerLimits(3, 5000);
+  
+  // Time each request by handler (one ESP8266_RouteStats for each of the 
+  // handlers above, in the same order) and keep the last 2 requests which
+  // took more than half a second, you can see them at /status
+  static ESP8266_RouteStats  routeStats[3];
+  static ESP8266_SlowRequest slowRequests[2];
+  wifi.profileServer(routeStats, 3, slowRequests, 2, 500);
+  wifi.setServerStatusRoute(PSTR("GET /status"));
+  
   // Start an "HTTP Server" on port 80, using our handlers above to process
   // the requests, with a maximum buffer size of 250 bytes.  Note that
   // your response to any requests must fit within the buffer size, and
@@ -130,6 +144,16 @@ void loop()
 
 unsigned long httpMillis(char *buffer, int bufferLength)
 {
+  // Programs rather than browsers can ask for the answer in CBOR (binary 
+  // JSON) which is much smaller, they say so with "Accept: application/cbor"
+  if(wifi.requestAcceptsCbor())
+  {
+    ESP8266_CborWriter cbor(buffer, bufferLength);
+    cbor.beginMap(1);
+      cbor.add(F("millis")); cbor.add(millis());
+    return cbor.response(200);
+  }
+  
   // empty the buffer
   memset(buffer,0,bufferLength);
   
@@ -140,7 +164,7 @@ unsigned long httpMillis(char *buffer, int bufferLength)
   strncpy_P(buffer+strlen(buffer), PSTR("</p>"), bufferLength-strlen(buffer));        
 
   // And return the type and HTTP response code combined with "|" (bitwise or)
-  // Valid  types are: ESP8266_HTML, ESP8266_TEXT, ESP8266_RAW
+  // Valid  types are: ESP8266_HTML, ESP8266_TEXT, ESP8266_RAW, ESP8266_CBOR
   // Valid  response codes are: any standard HTTP response code
   // The RAW type is sent without adding any headers, the other types add HTTP 
   // headers appropriately.
@@ -175,7 +199,7 @@ unsigned long httpLed(char *buffer, int bufferLength)
   strncpy_P(buffer, ledStatus ? PSTR("The D13 LED Status Is: ON") : PSTR("The D13 LED Status Is: OFF"), bufferLength-strlen(buffer));
   
   // And return the type and HTTP response code combined with "|" (bitwise or)
-  // Valid  types are: ESP8266_HTML, ESP8266_TEXT, ESP8266_RAW
+  // Valid  types are: ESP8266_HTML, ESP8266_TEXT, ESP8266_RAW, ESP8266_CBOR
   // Valid  response codes are: any standard HTTP response code (typically, 200 for OK, 404 for not found, and 500 for error)
   
   return ESP8266_TEXT | 200;
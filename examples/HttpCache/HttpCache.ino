@@ -0,0 +1,90 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+#include <ESP8266_HttpCache.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect up your ESP8266
+ESP8266_Simple wifi(8,9);
+
+// Keep bodies of up to 64 bytes, anything bigger only has it's ETag or 
+// Last-Modified remembered (so you get a 304 when it hasn't changed).
+ESP8266_HttpCache cache(&wifi, 64);
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo HTTP Cache Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  // Keep the cache in EEPROM bytes 0 to 511 so that it is still there after
+  // a reset, each entry takes sizeof(ESP8266_HttpCacheEntry) + 64 bytes.
+  // You could instead keep it in RAM with cache.setStorage(buffer, sizeof(buffer));
+  cache.setEepromStorage(0, 512);
+  
+  // A blank line just for debug formatting 
+  Serial.println();
+}
+
+void loop()
+{
+  char buffer[100];
+  unsigned long serverIp;
+  
+  wifi.ipConvertDatatypeFromTo("54.241.37.107", serverIp);  
+  
+  // Exactly like wifi.GET(), except the host is required (or the server 
+  // won't give us an ETag/Last-Modified), and if the document has not 
+  // changed since we last got it, it comes out of the cache.
+  strcpy_P(buffer, PSTR("/esp8266-config.txt"));
+  unsigned int httpResponseCode = cache.GET(serverIp, 80, buffer, sizeof(buffer), F("sparks.gogo.co.nz"));
+  
+  if(httpResponseCode == 200)
+  {
+    Serial.print(cache.wasCached() ? F("Not modified, from the cache: ") : F("Fresh from the server: "));
+    Serial.println(buffer);
+  }
+  else if(httpResponseCode == 304)
+  {
+    Serial.println(F("Not modified (too big to keep the body)"));
+  }
+  else
+  {
+    Serial.print(F("Error: "));
+    Serial.println(httpResponseCode);
+  }
+  
+  delay(30000);
+}
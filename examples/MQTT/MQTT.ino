@@ -0,0 +1,93 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+#include <ESP8266_MQTT.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// The IP address of your MQTT broker (eg mosquitto)
+#define BROKER_IP "192.168.1.2"
+
+// See the HelloWorld example for how to connect the ESP8266
+ESP8266_Simple wifi(8,9);
+
+// Incoming messages (topic and payload together) must fit in here
+char mqttBuffer[64];
+ESP8266_MQTT mqtt(&wifi, mqttBuffer, sizeof(mqttBuffer));
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("ESP8266 Demo MQTT Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  mqtt.setMessageHandler(messageReceived);
+}
+
+void loop()
+{        
+  static unsigned long lastReading = 0;
+  char reading[12];
+  unsigned long brokerIp;
+  
+  // Connect (or reconnect if the broker went away)
+  if(!mqtt.connected())
+  {
+    wifi.ipConvertDatatypeFromTo(BROKER_IP, brokerIp);
+    if(mqtt.connect(brokerIp, 1883, "arduino") != ESP8266_OK || mqtt.subscribe("arduino/led", 1) != ESP8266_OK)
+    {
+      Serial.println("Could not connect to the broker");
+      delay(5000);
+      return;
+    }
+    Serial.println("Connected to the broker");
+  }
+  
+  // Messages are received here
+  mqtt.loop();
+  
+  if(millis() - lastReading > 10000)
+  {
+    lastReading = millis();
+    itoa(analogRead(A0), reading, 10);
+    mqtt.publish("arduino/a0", reading);
+  }
+}
+
+// mosquitto_pub -t arduino/led -m on
+void messageReceived(const char *topic, char *payload, int length)
+{
+  pinMode(13, OUTPUT);
+  digitalWrite(13, strcmp(payload, "on") == 0 ? HIGH : LOW);
+}
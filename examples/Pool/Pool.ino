@@ -0,0 +1,84 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+#include <ESP8266_Pool.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// Two ESP8266 modules, one on pins 8 and 9, the other on 10 and 11, 
+// see the HelloWorld example for how to connect them up.
+ESP8266_Simple wifiA(8,9);
+ESP8266_Simple wifiB(10,11);
+
+ESP8266_Simple *modules[] = { &wifiA, &wifiB };
+ESP8266_Pool    wifi(modules, 2);
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo Pool Sketch");
+
+  // Each module needs to be started and connected as usual
+  wifiA.begin(9600);
+  wifiA.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  wifiB.begin(9600);
+  wifiB.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  // If a module fails 2 requests in a row, leave it alone for 
+  // 10 seconds before trying it again.
+  wifi.setHealthThresholds(2, 10000);
+  
+  // A blank line just for debug formatting 
+  Serial.println();
+}
+
+void loop()
+{
+  char buffer[100]; 
+  memset(buffer, 0, sizeof(buffer));
+  strncpy_P(buffer, PSTR("/esp8266-hello.html"), sizeof(buffer)-1);
+  
+  unsigned long serverIp;
+  wifiA.ipConvertDatatypeFromTo("54.241.37.107", serverIp);
+  
+  // Requests alternate between the modules, if one fails the other 
+  // is tried, so as long as one module is working this works.
+  unsigned int httpResponseCode = wifi.GET(serverIp, 80, buffer, sizeof(buffer), F("sparks.gogo.co.nz"), 2);
+  
+  Serial.print("Response ");
+  Serial.print(httpResponseCode);
+  Serial.print(" with ");
+  Serial.print(wifi.numHealthyModules());
+  Serial.println(" healthy modules");
+  
+  delay(5000);
+}
@@ -0,0 +1,83 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+
+// See the HelloWorld example for how to connect up your ESP8266
+ESP8266_Simple wifi(8,9);
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo Access Point Scan Sketch");
+
+  wifi.begin(9600);
+  
+  // We need to be in station mode to scan
+  wifi.setWifiMode(ESP8266_STATION);
+}
+
+// This is called for every access point found, as it is found
+void printAccessPoint(ESP8266_AccessPoint *accessPoint)
+{
+  Serial.print(accessPoint->rssi);
+  Serial.print("dBm Ch");
+  Serial.print(accessPoint->channel);
+  Serial.print(" ");
+  Serial.println(accessPoint->ssid);
+}
+
+void loop()
+{
+  // Keep the 3 strongest access points we find
+  ESP8266_AccessPoint strongest[3];
+  unsigned int        numFound;
+  
+  Serial.println("All Access Points:");
+  wifi.scanAccessPoints(printAccessPoint, strongest, 3, NULL, &numFound);
+  
+  Serial.print("Found ");
+  Serial.print(numFound);
+  Serial.println(", the strongest are:");
+  for(byte i = 0; i < 3 && strongest[i].ssid[0]; i++)
+  {
+    printAccessPoint(&strongest[i]);
+  }
+  
+  // If you only care about one network, say so and the scan is quicker, 
+  // here we just want to know how strong it is.
+  wifi.scanAccessPoints(NULL, strongest, 1, "MyNetwork");
+  if(strongest[0].ssid[0])
+  {
+    Serial.print("MyNetwork is at ");
+    Serial.print(strongest[0].rssi);
+    Serial.println("dBm");
+  }
+  
+  Serial.println();
+  delay(10000);
+}
@@ -0,0 +1,110 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+#include <ESP8266_TelemetryQueue.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect up your ESP8266
+ESP8266_Simple wifi(8,9);
+
+// Each of our readings is one of these, they are stored exactly like this
+// in the queue so keep them small.
+struct Reading
+{
+  unsigned long time;
+  int           value;
+};
+
+// Room for 40 readings in RAM
+byte readingsBuffer[40 * sizeof(Reading)];
+
+// The queue needs to know how to print a reading into the body of 
+// the POST that sends them, here we do one comma separated line per reading.
+void writeReading(Print *body, const void *record)
+{
+  const Reading *reading = (const Reading *) record;
+  body->print(reading->time);
+  body->print(',');
+  body->println(reading->value);
+}
+
+ESP8266_TelemetryQueue readings(&wifi, readingsBuffer, sizeof(readingsBuffer), sizeof(Reading), writeReading);
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo Telemetry Queue Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  // Where to send the readings
+  unsigned long serverIp;
+  wifi.ipConvertDatatypeFromTo("54.241.37.107", serverIp);  
+  readings.setDestination(serverIp, 80, F("/esp8266-readings.php"), F("sparks.gogo.co.nz"), F("text/csv"));
+  
+  // Send when we have 30 readings, or the oldest is a minute old
+  readings.setFlushThresholds(30, 0, 60000UL);
+  
+  // If the server can't be reached, wait 2 seconds before trying again, 
+  // then 4, then 8... up to 2 minutes.  The readings are kept (in order) 
+  // until they are sent.
+  readings.setRetryBackoff(2000, 120000UL);
+  
+  // If the RAM fills up while we can't send, keep up to 200 more readings in 
+  // EEPROM (bytes 0 to 1199) rather than losing them.
+  readings.setEepromSpill(0, 200 * sizeof(Reading));
+  
+  // A blank line just for debug formatting 
+  Serial.println();
+}
+
+void loop()
+{
+  static unsigned long lastReading = 0;
+  
+  // Take a reading every 500mS, this is very quick, it does not 
+  // touch the network at all.
+  if(millis() - lastReading >= 500)
+  {
+    Reading reading;
+    reading.time  = millis();
+    reading.value = analogRead(A0);
+    readings.push(&reading);
+    
+    lastReading = reading.time;
+  }
+  
+  // And this sends them off when it is time to.
+  readings.poll();
+}
@@ -0,0 +1,93 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect up your ESP8266
+ESP8266_Simple wifi(8,9);
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("ESP8266 Demo UDP Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  // UDP has no connection as such, but the ESP8266 wants us to "open" one 
+  // anyway to say where the datagrams should go, here we send to port 
+  // 8125 (statsd) on our collector, and receive anything sent back to 
+  // us on local port 8125.  Receiving on a local port needs firmware 
+  // 0.9.5.2 or later, use 0 if you only want to send.
+  unsigned long collectorIp;
+  wifi.ipConvertDatatypeFromTo("192.168.1.10", collectorIp);
+  
+  Serial.print("Open UDP: ");
+  wifi.debugPrintError(wifi.openConnection(ESP8266_UDP, collectorIp, 8125, 8125), &Serial);
+  
+  // Whenever a datagram arrives, receiveDatagram() (below) will call this 
+  // handler, datagrams longer than 32 bytes will be truncated.
+  wifi.setDatagramHandler(gotDatagram, 32);
+  
+  // A blank line just for debug formatting 
+  Serial.println();
+}
+
+void loop()
+{
+  static unsigned long lastSent = 0;
+  
+  // You should call wifi.receiveDatagram() as often as possible to ensure 
+  //  that you don't miss any
+  wifi.receiveDatagram();
+  
+  if(millis() - lastSent > 1000)
+  {
+    // Each sendData() is one datagram, there is no handshake, no reply
+    // just fire and forget.
+    char buffer[32];
+    memset(buffer, 0, sizeof(buffer));
+    strncpy_P(buffer, PSTR("sensor.a0:"), sizeof(buffer)-1);
+    itoa(analogRead(A0), buffer+strlen(buffer), 10);
+    strncpy_P(buffer+strlen(buffer), PSTR("|g"), sizeof(buffer)-strlen(buffer)-1);
+    
+    wifi.sendData(-1, buffer, strlen(buffer));
+    lastSent = millis();
+  }
+}
+
+void gotDatagram(char *data, int length, int muxChannel)
+{
+  Serial.print("Received: ");
+  Serial.println(data);
+}
@@ -0,0 +1,108 @@
+/** 
+ * Copyright (C) 2014 James Sleeman
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ * 
+ * @author James Sleeman, http://sparks.gogo.co.nz/
+ * @license MIT License
+ */
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+
+// WebSockets are left out by default on an Uno (and other 32K boards), to fit
+// set ESP8266_ENABLE_WEBSOCKET to 1 and ESP8266_ENABLE_HTTP_CLIENT to 0 in 
+// ESP8266_Simple.h, or use a bigger board (eg Mega)
+#if !ESP8266_ENABLE_WEBSOCKET
+  #error "Set ESP8266_ENABLE_WEBSOCKET to 1 in ESP8266_Simple.h, see above"
+#endif
+
+// These are the SSID and PASSWORD to connect to your Wifi Network
+//  put details appropriate for your network between the quote marks,
+//  eg  #define ESP8266_SSID "YOUR_SSID"
+#define ESP8266_SSID  ""
+#define ESP8266_PASS  ""
+
+// See the HelloWorld example for how to connect the ESP8266
+ESP8266_Simple wifi(8,9);
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("ESP8266 Demo WebSocket Sketch");
+
+  wifi.begin(9600);
+  wifi.setupAsWifiStation(ESP8266_SSID, ESP8266_PASS, &Serial);
+  
+  // In a browser
+  //   ws = new WebSocket("ws://[the ip address]/ws");
+  //   ws.onmessage = function(e) { console.log(e.data); };
+  //   ws.send("on");
+  static ESP8266_HttpServerHandler myServerHandlers[] = {
+    { PSTR("GET /ws"), httpWebSocket },    
+    { PSTR("GET "),    http404       } 
+  };
+  
+  wifi.setWebSocketHandler(webSocketReceived);
+  wifi.startHttpServer(80, myServerHandlers, sizeof(myServerHandlers), 100, &Serial);
+  Serial.println();
+}
+
+void loop()
+{        
+  static unsigned long lastReading = 0;
+  char reading[12];
+  
+  wifi.serveHttpRequest(); 
+  
+  // Send a reading to every WebSocket 10 times a second
+  if(millis() - lastReading > 100)
+  {
+    lastReading = millis();
+    itoa(analogRead(A0), reading, 10);
+    wifi.sendWebSocket(-1, reading, strlen(reading));
+  }
+}
+
+unsigned long httpWebSocket(char *buffer, int bufferLength)
+{
+  return ESP8266_WEBSOCKET;
+}
+
+// "on" or "off" turns the D13 LED on or off
+void webSocketReceived(int muxChannel, byte opcode, char *data, int length, byte final)
+{
+  if(opcode == ESP8266_WS_CLOSE)
+  {
+    Serial.println("WebSocket closed");
+    return;
+  }
+  
+  pinMode(13, OUTPUT);
+  if(length == 2 && strncmp(data, "on", 2) == 0)  digitalWrite(13, HIGH);
+  if(length == 3 && strncmp(data, "off", 3) == 0) digitalWrite(13, LOW);
+}
+
+unsigned long http404(char *buffer, int bufferLength)
+{  
+  memset(buffer, 0, bufferLength);  
+  strcpy_P(buffer, PSTR("Try a WebSocket to /ws"));
+  return ESP8266_TEXT | 404;
+}
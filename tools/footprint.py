@@ -0,0 +1,343 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2014 James Sleeman
+#
+# Permission is hereby granted, free of charge, to any person obtaining a 
+# copy of this software and associated documentation files (the "Software"), 
+# to deal in the Software without restriction, including without limitation 
+# the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+# and/or sell copies of the Software, and to permit persons to whom the 
+# Software is furnished to do so, subject to the following conditions:
+# 
+# The above copyright notice and this permission notice shall be included in 
+# all copies or substantial portions of the Software.
+# 
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+# THE SOFTWARE.
+# 
+# @author James Sleeman, http://sparks.gogo.co.nz/
+# @license MIT License
+
+
+"""
+Build a small sketch with each set of ESP8266_ENABLE_... switches and show 
+what it costs, flash (.text + .data) and RAM (.data + .bss) over a sketch 
+which only uses Serial, and an estimate of the deepest the stack goes, 
+exiting with 1 if any doesn't fit the board (the whole sketch in its flash, 
+and RAM, the stack and the server's request buffer in its SRAM) or is over 
+a budget given for it in CONFIGS.
+
+Needs arduino-cli with the arduino:avr core installed (avr-size and 
+avr-objdump are found in the core's tools).
+
+  python3 tools/footprint.py
+  python3 tools/footprint.py --only full --only client
+
+The stack estimate is the biggest sum of frame sizes (from -fstack-usage) 
+down any chain of direct calls from main(), plus the biggest interrupt 
+handler.  Calls through function pointers (your handlers) can't be followed, 
+so leave room for them, and for recursion (shown with a *).  Nor can variable
+length arrays, so the server's request buffer (maxBufferSize, REQUEST_BUFFER
+in the sketch) is added to it when checking against the board's SRAM.
+"""
+
+import argparse
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+LIBRARY = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# name, -D switches, and budgets for flash and RAM over BASELINE, and stack
+# (bytes), None for no budget other than fitting the board.
+#
+# Budgets are only worth having when they come from measuring this with the
+# avr-gcc the core uses, and are never more than the board has, so fill them
+# in from a run of this (plus a margin) rather than guessing.  "full" is what
+# you get by default, on 32K boards that is without WebSockets.
+CONFIGS = [
+  ('full',    [],
+    None, None, None),
+  ('client',  ['ESP8266_ENABLE_SERVER=0'],
+    None, None, None),
+  ('server',  ['ESP8266_ENABLE_HTTP_CLIENT=0', 'ESP8266_ENABLE_WEBSOCKET=0'],
+    None, None, None),
+  ('server-websocket', ['ESP8266_ENABLE_HTTP_CLIENT=0', 'ESP8266_ENABLE_WEBSOCKET=1'],
+    None, None, None),
+  ('minimal', ['ESP8266_ENABLE_SERVER=0', 'ESP8266_ENABLE_HTTP_CLIENT=0', 'ESP8266_ENABLE_ADAPTIVE_TIMEOUTS=0', 'ESP8266_ENABLE_ERROR_MESSAGES=0'],
+    None, None, None),
+]
+
+# The sketch gives the server this much for each request, it's a variable 
+# length array so it's on the stack while serving
+REQUEST_BUFFER = 250
+
+# What the core costs on it's own, taken off each configuration so that the 
+# budgets are for the library whichever version of the core is installed
+BASELINE = r'''
+#include <Arduino.h>
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("ok"));
+}
+
+void loop()
+{
+}
+'''
+
+# Each configuration builds this, it uses everything the switches leave in 
+# so that none of it is thrown away by the linker.
+SKETCH = r'''
+#include <Arduino.h>
+#define REQUEST_BUFFER %d
+#include <SoftwareSerial.h>
+#include <ESP8266_Simple.h>
+
+ESP8266_Simple wifi(8,9);
+
+#if ESP8266_ENABLE_SERVER
+unsigned long handler(char *buffer, int bufferLength)
+{
+  strcpy_P(buffer, PSTR("ok"));
+  return ESP8266_TEXT | 200;
+}
+#endif
+
+#if ESP8266_ENABLE_WEBSOCKET
+void webSocket(int muxChannel, byte opcode, char *data, int length, byte final)
+{
+  wifi.sendWebSocket(muxChannel, data, length, opcode);
+}
+#endif
+
+void setup()
+{
+  char buffer[50];
+  
+  Serial.begin(115200);
+  wifi.begin(9600);
+  wifi.setupAsWifiStation("ssid", "pass", &Serial);
+  
+#if ESP8266_ENABLE_ADAPTIVE_TIMEOUTS
+  wifi.setAdaptiveTimeouts(150);
+#endif
+#if ESP8266_ENABLE_WEBSOCKET
+  wifi.setWebSocketHandler(webSocket);
+#endif
+#if ESP8266_ENABLE_SERVER
+  wifi.startHttpServer(80, handler, REQUEST_BUFFER);
+#endif
+  
+  wifi.getErrorMessage(wifi.connectToWifi("ssid", "pass"), buffer);
+  Serial.println(buffer);
+}
+
+void loop()
+{
+#if ESP8266_ENABLE_HTTP_CLIENT
+  char buffer[100];
+  strcpy_P(buffer, PSTR("/"));
+  Serial.println(wifi.GET(0x01020304UL, 80, buffer, sizeof(buffer)));
+#endif
+#if ESP8266_ENABLE_SERVER
+  wifi.serveHttpRequest();
+#endif
+}
+''' % REQUEST_BUFFER
+
+def run(command, **kwargs):
+  result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True, **kwargs)
+  if result.returncode:
+    sys.stderr.write(result.stdout)
+    sys.exit('Failed: ' + ' '.join(command))
+  return result.stdout
+
+def find_tool(name):
+  found = shutil.which(name)
+  if found:
+    return found
+  # arduino-cli keeps its own avr-gcc
+  for root in (os.path.expanduser('~/.arduino15'), os.path.expanduser('~/Library/Arduino15'), os.path.expandvars('$LOCALAPPDATA/Arduino15')):
+    candidates = sorted(glob.glob(os.path.join(root, 'packages', 'arduino', 'tools', 'avr-gcc', '*', 'bin', name + '*')))
+    if candidates:
+      return candidates[-1]
+  sys.exit('Can not find ' + name + ', is the arduino:avr core installed?')
+
+def board_limits(fqbn):
+  # The flash a sketch may use (less the bootloader) and the SRAM
+  limits = {}
+  for line in run(['arduino-cli', 'board', 'details', '--fqbn', fqbn, '--show-properties']).splitlines():
+    key, _, value = line.partition('=')
+    if key in ('upload.maximum_size', 'upload.maximum_data_size') and value.strip().isdigit():
+      limits[key] = int(value)
+  if len(limits) < 2:
+    sys.exit('Can not find the flash and RAM sizes of ' + fqbn)
+  return limits['upload.maximum_size'], limits['upload.maximum_data_size']
+
+def sizes(elf):
+  text = data = bss = 0
+  for line in run([find_tool('avr-size'), '-A', elf]).splitlines():
+    fields = line.split()
+    if len(fields) < 2:
+      continue
+    if fields[0] in ('.text', '.data', '.bss', '.noinit'):
+      size = int(fields[1])
+      if fields[0] == '.text':
+        text += size
+      elif fields[0] == '.data':
+        data += size
+      else:
+        bss  += size
+  # .data is also in flash, it is copied to RAM at startup
+  return text + data, data, bss
+
+def normalise(function):
+  # The .su files and objdump don't always agree on spaces and return types
+  function = re.sub(r'^[\w:<> ]+? (?=[\w:~]+\()', '', function)
+  return function.replace(' ', '')
+
+def frame_sizes(build):
+  frames = {}
+  for su in glob.glob(os.path.join(build, '**', '*.su'), recursive=True):
+    with open(su) as f:
+      for line in f:
+        # file.cpp:123:6:byte ESP8266_Simple::readIPD(char*, ...)	42	static
+        parts = line.rstrip('\n').split('\t')
+        if len(parts) < 2:
+          continue
+        function = normalise(parts[0].split(':', 3)[-1])
+        frames[function] = max(frames.get(function, 0), int(parts[1]))
+        # The arguments may be written with typedefs (byte, uint8_t), so
+        # also by name alone, the biggest of any overloads
+        name = function.split('(')[0]
+        frames[name] = max(frames.get(name, 0), int(parts[1]))
+  return frames
+
+def call_graph(elf):
+  calls    = {}
+  function = None
+  for line in run([find_tool('avr-objdump'), '-d', '-C', elf]).splitlines():
+    label = re.match(r'^[0-9a-f]+ <(.+)>:$', line)
+    if label:
+      function = normalise(label.group(1))
+      calls.setdefault(function, set())
+      continue
+    call = re.search(r'\s(?:call|rcall|jmp|rjmp)\s.*<(.+?)(?:\+0x[0-9a-f]+)?>', line)
+    if call and function:
+      target = normalise(call.group(1))
+      if target != function:
+        calls[function].add(target)
+  return calls
+
+def deepest(function, calls, frames, visiting, known):
+  if function in known:
+    return known[function]
+  if function in visiting:
+    return 0, True
+  visiting.add(function)
+  below, recursive = 0, False
+  for callee in calls.get(function, ()):
+    depth, callee_recursive = deepest(callee, calls, frames, visiting, known)
+    below     = max(below, depth)
+    recursive = recursive or callee_recursive
+  visiting.discard(function)
+  # A call pushes the return address, 2 bytes (3 on the big megas, near enough)
+  frame = frames.get(function, frames.get(function.split('(')[0], 0))
+  known[function] = (frame + 2 + below, recursive)
+  return known[function]
+
+def stack(build, elf):
+  frames = frame_sizes(build)
+  calls  = call_graph(elf)
+  known  = {}
+  peak, recursive = deepest('main', calls, frames, set(), known)
+  interrupts = [deepest(f, calls, frames, set(), known) for f in calls if f.startswith('__vector_')]
+  if interrupts:
+    # An interrupt also pushes the registers it uses, which are in its frame
+    peak      += max(depth for depth, r in interrupts)
+    recursive  = recursive or any(r for depth, r in interrupts)
+  return peak, recursive
+
+def build(name, source, defines, fqbn, sketchbook, keep):
+  sketch = os.path.join(sketchbook, 'footprint_' + re.sub(r'[^A-Za-z0-9]', '_', name))
+  os.makedirs(sketch)
+  with open(os.path.join(sketch, os.path.basename(sketch) + '.ino'), 'w') as f:
+    f.write(source)
+  
+  flags = ' '.join('-D' + define for define in defines) + ' -fstack-usage'
+  out   = os.path.join(sketch, 'build')
+  run(['arduino-cli', 'compile', '--fqbn', fqbn, '--library', LIBRARY, '--build-path', out,
+       '--build-property', 'compiler.cpp.extra_flags=' + flags,
+       '--build-property', 'compiler.c.extra_flags=' + flags,
+       sketch])
+  
+  elf = glob.glob(os.path.join(out, '*.elf'))[0]
+  text, data, bss = sizes(elf)
+  peak, recursive = stack(out, elf)
+  if keep:
+    print('  %s built in %s' % (name, out))
+  return text, data + bss, peak, recursive
+
+def main():
+  parser = argparse.ArgumentParser(description='Show the flash, RAM and stack each set of ESP8266_ENABLE_... switches costs')
+  parser.add_argument('--fqbn', default='arduino:avr:uno', help='board to build for (default arduino:avr:uno)')
+  parser.add_argument('--only', action='append', choices=[config[0] for config in CONFIGS], help='just this configuration (can be given more than once)')
+  parser.add_argument('--keep', action='store_true', help='keep the builds, to look at the .map, .su...')
+  args = parser.parse_args()
+  
+  if not shutil.which('arduino-cli'):
+    sys.exit('Needs arduino-cli, https://arduino.github.io/arduino-cli/')
+  
+  sketchbook = tempfile.mkdtemp(prefix='esp8266_footprint_')
+  over       = []
+  
+  try:
+    max_text, max_ram = board_limits(args.fqbn)
+    base_text, base_ram, base_peak, _ = build('baseline', BASELINE, [], args.fqbn, sketchbook, args.keep)
+    print('%-22s %8s %8s %8s' % ('', 'flash', 'ram', 'stack'))
+    print('%-22s %8d %8d' % ('(' + args.fqbn + ')', max_text, max_ram))
+    print('%-22s %8d %8d %7d' % ('(baseline)', base_text, base_ram, base_peak))
+    
+    for name, defines, text_budget, ram_budget, stack_budget in CONFIGS:
+      if args.only and name not in args.only:
+        continue
+      
+      total_text, total_ram, peak, recursive = build(name, SKETCH, defines, args.fqbn, sketchbook, args.keep)
+      text = total_text - base_text
+      ram  = total_ram  - base_ram
+      print('%-22s %+8d %+8d %7d%s' % (name, text, ram, peak, '*' if recursive else ' '))
+      
+      # What has to fit the board is the whole sketch, with the stack (and
+      # the request buffer on it) sharing the SRAM with the variables
+      if total_text > max_text:
+        over.append('%s flash is %d bytes, the board has %d' % (name, total_text, max_text))
+      needs = total_ram + peak + (0 if 'ESP8266_ENABLE_SERVER=0' in defines else REQUEST_BUFFER)
+      if needs > max_ram:
+        over.append('%s ram and stack is %d bytes, the board has %d' % (name, needs, max_ram))
+      
+      # A budget can't be more than the board leaves after the baseline
+      for what, used, budget, most in (('flash', text, text_budget, max_text - base_text), ('ram', ram, ram_budget, max_ram - base_ram), ('stack', peak, stack_budget, max_ram - total_ram)):
+        if budget is not None and used > min(budget, most):
+          over.append('%s %s is %d bytes, budget %d' % (name, what, used, min(budget, most)))
+  finally:
+    if not args.keep:
+      shutil.rmtree(sketchbook, ignore_errors=True)
+  
+  for line in over:
+    print('Over: ' + line)
+  sys.exit(1 if over else 0)
+
+if __name__ == '__main__':
+  main()
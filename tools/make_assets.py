@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2014 James Sleeman
+#
+# Permission is hereby granted, free of charge, to any person obtaining a 
+# copy of this software and associated documentation files (the "Software"), 
+# to deal in the Software without restriction, including without limitation 
+# the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+# and/or sell copies of the Software, and to permit persons to whom the 
+# Software is furnished to do so, subject to the following conditions:
+# 
+# The above copyright notice and this permission notice shall be included in 
+# all copies or substantial portions of the Software.
+# 
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+# THE SOFTWARE.
+# 
+# @author James Sleeman, http://sparks.gogo.co.nz/
+# @license MIT License
+
+"""
+Turn a directory of web files (html, css, js, images...) into a header of 
+PROGMEM ESP8266_HttpAsset for ESP8266_Simple::setHttpAssets().
+
+Each file is gzipped (unless that doesn't make it smaller) and it's whole 
+response header (Content-Type, Content-Encoding, Content-Length, ETag) is 
+made now, so the Arduino just sends it all from flash.
+
+  python3 tools/make_assets.py data web_assets.h
+
+and in your sketch
+
+  #include "web_assets.h"
+  ...
+  wifi.setHttpAssets(webAssets, WEBASSETS_COUNT);
+
+data/index.html is served as /index.html and also as /
+"""
+
+import argparse
+import gzip
+import os
+import re
+import sys
+import zlib
+
+CONTENT_TYPES = {
+  '.html': 'text/html',
+  '.htm':  'text/html',
+  '.css':  'text/css',
+  '.js':   'application/javascript',
+  '.json': 'application/json',
+  '.txt':  'text/plain',
+  '.svg':  'image/svg+xml',
+  '.png':  'image/png',
+  '.gif':  'image/gif',
+  '.jpg':  'image/jpeg',
+  '.jpeg': 'image/jpeg',
+  '.ico':  'image/x-icon',
+}
+
+def c_string(text):
+  return '"' + text.replace('\\', '\\\\').replace('"', '\\"').replace('\r', '\\r').replace('\n', '\\n') + '"'
+
+def c_bytes(data):
+  lines = []
+  for x in range(0, len(data), 16):
+    lines.append('  ' + ', '.join('0x%02x' % b for b in data[x:x+16]) + ',')
+  return '\n'.join(lines)
+
+def make_asset(root, path, max_age):
+  with open(os.path.join(root, path), 'rb') as f:
+    content = f.read()
+  
+  # mtime=0 so that the same files always make the same header
+  body    = gzip.compress(content, 9, mtime=0)
+  gzipped = len(body) < len(content)
+  if not gzipped:
+    body = content
+  
+  etag         = '"%08x"' % (zlib.crc32(content) & 0xFFFFFFFF)
+  content_type = CONTENT_TYPES.get(os.path.splitext(path)[1].lower(), 'application/octet-stream')
+  
+  headers  = 'HTTP/1.0 200 OK\r\n'
+  headers += 'Content-Type: %s\r\n' % content_type
+  if gzipped:
+    headers += 'Content-Encoding: gzip\r\n'
+  headers += 'Content-Length: %d\r\n' % len(body)
+  headers += 'ETag: %s\r\n' % etag
+  if max_age:
+    headers += 'Cache-Control: max-age=%d\r\n' % max_age
+  else:
+    headers += 'Cache-Control: no-cache\r\n'
+  headers += '\r\n'
+  
+  url = '/' + path.replace(os.sep, '/')
+  return {
+    'urls':     [url, url[:-len('index.html')]] if os.path.basename(path) == 'index.html' else [url],
+    'name':     re.sub(r'[^A-Za-z0-9]', '_', path),
+    'headers':  headers,
+    'body':     body,
+    'etag':     etag,
+    'original': len(content),
+  }
+
+def main():
+  parser = argparse.ArgumentParser(description='Make a PROGMEM header of gzipped web files for ESP8266_Simple::setHttpAssets()')
+  parser.add_argument('directory', help='the files to serve')
+  parser.add_argument('output',    help='the header to write, eg web_assets.h')
+  parser.add_argument('--name',    default='webAssets', help='name of the ESP8266_HttpAsset table (default webAssets)')
+  parser.add_argument('--max-age', type=int, default=0, help='seconds browsers may keep them without asking (default 0, they ask and get 304 Not Modified)')
+  args = parser.parse_args()
+  
+  paths = []
+  for directory, subdirectories, files in os.walk(args.directory):
+    subdirectories.sort()
+    for name in sorted(files):
+      paths.append(os.path.relpath(os.path.join(directory, name), args.directory))
+  
+  if not paths:
+    sys.exit('No files in ' + args.directory)
+  
+  assets = [make_asset(args.directory, path, args.max_age) for path in paths]
+  guard  = re.sub(r'[^A-Za-z0-9]', '_', os.path.basename(args.output)).upper()
+  prefix = args.name + '_'
+  out    = []
+  
+  out.append('// Generated by tools/make_assets.py from %s, do not edit' % args.directory)
+  out.append('#ifndef %s' % guard)
+  out.append('#define %s' % guard)
+  out.append('')
+  out.append('#include <ESP8266_Simple.h>')
+  out.append('')
+  
+  for asset in assets:
+    name = prefix + asset['name']
+    out.append('// %s, %d bytes (%d before gzip)' % (asset['urls'][0], len(asset['body']), asset['original']))
+    for x, url in enumerate(asset['urls']):
+      out.append('static const char %s_request%d[] PROGMEM = %s;' % (name, x, c_string('GET %s ' % url)))
+    out.append('static const char %s_headers[] PROGMEM = %s;' % (name, c_string(asset['headers'])))
+    out.append('static const char %s_etag[] PROGMEM = %s;' % (name, c_string(asset['etag'])))
+    out.append('static const byte %s_body[] PROGMEM = {' % name)
+    out.append(c_bytes(asset['body']))
+    out.append('};')
+    out.append('')
+  
+  out.append('static const ESP8266_HttpAsset %s[] PROGMEM = {' % args.name)
+  for asset in assets:
+    name = prefix + asset['name']
+    for x, url in enumerate(asset['urls']):
+      out.append('  { %s_request%d, %s_headers, %s_body, sizeof(%s_body), %s_etag },' % (name, x, name, name, name, name))
+  out.append('};')
+  out.append('')
+  out.append('#define %s_COUNT (sizeof(%s) / sizeof(%s[0]))' % (args.name.upper(), args.name, args.name))
+  out.append('')
+  out.append('#endif')
+  
+  with open(args.output, 'w') as f:
+    f.write('\n'.join(out) + '\n')
+  
+  total    = sum(len(asset['body']) for asset in assets)
+  original = sum(asset['original'] for asset in assets)
+  print('%d files, %d bytes of flash (%d before gzip)' % (len(assets), total, original))
+
+if __name__ == '__main__':
+  main()